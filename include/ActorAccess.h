@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "ActorStateTable.h"
+
+struct Vec3 {
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+};
+
+// Opaque actor handle for the controller core.
+// handle is the engine object (RE::Actor* in game, a simulated actor in the harness), the core never dereferences it.
+struct ActorRef {
+    void* handle = nullptr;
+    std::uint32_t formID = 0;
+
+    bool IsPlayer() const { return formID == ActorStateTable::kPlayerFormID; }
+    explicit operator bool() const { return handle != nullptr; }
+    bool operator==(const ActorRef& o) const { return handle == o.handle; }
+};
+
+enum class ActorStat : std::uint8_t { SpeedMult, WeaponSpeedMult, Health, Stamina, Magicka };
+
+struct ArmorWeight {
+    float sum = 0.0f;
+    float max = 0.0f;
+};
+
+// Where an actor is. Opaque engine pointers (BGSLocation / TESObjectCELL in game), only compared or handed back.
+struct ActorPlace {
+    const void* location = nullptr;
+    const void* cell = nullptr;
+    bool interior = false;
+};
+
+// One actor's engine state for one tick. Filled once by the gather stage, every later stage reads only this.
+// speedMult is kept in sync with our own writes during the tick, so it always matches the engine value.
+struct ActorInputs {
+    std::uint64_t nowMs = 0;
+
+    Vec3 pos{};
+    float scale = 1.0f;  // sanitized, 1 if the engine reports nonsense
+
+    float speedMult = 0.0f;
+    float health = 0.0f, healthMax = 0.0f;
+    float stamina = 0.0f, staminaMax = 0.0f;
+    float magicka = 0.0f, magickaMax = 0.0f;
+
+    float moveX = 0.0f, moveY = 0.0f;  // player: input axes, NPCs: graph
+    ArmorWeight armor{};
+    bool armorCached = false;  // armor not read, SpeedCore still has the contribution from the last read
+    bool equipChanged = false;  // equip event since the last gather, armor and weapon were read again
+
+    ActorPlace place{};
+    float locationMod = 0.0f;
+    float weatherMod = 0.0f;
+
+    bool sprinting = false;
+    bool sneaking = false;
+    bool drawn = false;
+    bool combat = false;
+    bool beast = false;
+    bool inRange = true;
+    bool hasLocationMod = false;
+    bool hasWeatherMod = false;
+    bool reduced = false;  // mid/far LOD tier: movement case only, no diagonal/slope/scale stages
+
+    // Filled for a whole NPC chunk by the batch kernels (SpeedCore::PrecomputeChunk) before ApplyFor runs.
+    // Unset for the player and event-driven updates, those compute the same values per actor.
+    struct Precomputed {
+        bool valid = false;
+        bool pathPushed = false;  // this tick's path sample is already in the ring
+        bool haveSlope = false;
+        float want = 0.0f;        // movement target, NPC percent applied
+        float smoothed = 0.0f;    // SmoothCombined(moveDelta, want, dt), = want without smoothing
+        float diagFactor = 1.0f;  // MovementMath::DiagonalFactor(moveX, moveY)
+        float slopeDeg = 0.0f;
+    } pre;
+
+    // SpeedMult write-back. While batching, SpeedCore sums the component deltas here (speedMult above already
+    // includes them) and commits one ModActorValue + one refresh per actor at the end of the update.
+    bool batching = false;
+    bool refreshWanted = false;
+    std::uint16_t pendingWrites = 0;
+    float pendingSpeedMult = 0.0f;
+};
+
+// Everything SpeedCore needs from the game, nothing more.
+// SpeedController implements this on top of CommonLibSSE, the simulation harness on top of synthetic actors.
+class ActorAccess {
+public:
+    virtual ~ActorAccess() = default;
+
+    virtual std::uint64_t NowMs() const = 0;
+
+    // State
+    virtual bool IsSprinting(ActorRef a) const = 0;  // includes the player's input latch
+    virtual bool IsSneaking(ActorRef a) const = 0;
+    virtual bool IsInCombat(ActorRef a) const = 0;
+    virtual bool IsWeaponDrawn(ActorRef a) const = 0;
+    virtual bool IsInBeastForm(ActorRef a) const = 0;  // SpeedCore only asks again after GetRace changed
+    virtual const void* GetRace(ActorRef a) const = 0;   // opaque (TESRace* in game), only compared
+    virtual bool GetMoveAxes(ActorRef a, float& outX, float& outY) const = 0;  // NPCs only, player uses input
+    virtual Vec3 GetPosition(ActorRef a) const = 0;
+    virtual float GetScale(ActorRef a) const = 0;
+    virtual float GetEquippedWeight(ActorRef a) const = 0;
+    virtual ArmorWeight GetArmorWeight(ActorRef a) const = 0;
+    virtual ActorPlace GetPlace(ActorRef a) const = 0;
+
+    // Resolved location / weather rule values ("reduce" amounts), nullopt if no rule matches.
+    // Weather is global, GetWeatherModifier may only look at p.interior (SpeedCore resolves it once per tick).
+    virtual std::optional<float> GetLocationModifier(const ActorPlace& p) const = 0;
+    virtual std::optional<float> GetWeatherModifier(const ActorPlace& p) const = 0;
+
+    // Actor values
+    virtual float GetActorValue(ActorRef a, ActorStat av) const = 0;
+    virtual float GetPermanentActorValue(ActorRef a, ActorStat av) const = 0;
+    virtual void ModActorValue(ActorRef a, ActorStat av, float delta) = 0;
+
+    // Side effects
+    virtual bool ForceSpeedRefresh(ActorRef a) = 0;  // make the engine pick up a new SpeedMult now
+    virtual void RequestRefresh(ActorRef a) = 0;     // same, but deferred to the next heartbeat
+    virtual void PublishSweat(ActorRef a, float intensity) = 0;  // sets the wetness masks, intensity > 0
+    virtual void ClearSweat(ActorRef a) = 0;                      // removes them
+};
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct PathSample {
+    float x, y, z;
+    float sxy;     // Cumulative distance in XY plane
+    uint64_t tMs;  // Timestamp in milliseconds
+};
+
+// Fixed-capacity ring of path samples, oldest first. Capacity is a power of two and only changes on Reset().
+// Pushing into a full ring drops the oldest sample. sxy is non-decreasing from front to back.
+class PathRing {
+public:
+    void Reset(std::uint32_t capacity) {
+        std::uint32_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        buf_.assign(cap, PathSample{});
+        mask_ = cap - 1;
+        head_ = 0;
+        size_ = 0;
+    }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    std::uint32_t capacity() const { return static_cast<std::uint32_t>(buf_.size()); }
+
+    const PathSample& operator[](std::size_t i) const { return buf_[(head_ + i) & mask_]; }
+    const PathSample& front() const { return buf_[head_]; }
+    const PathSample& back() const { return (*this)[size_ - 1]; }
+
+    void push_back(const PathSample& p) {
+        if (size_ == buf_.size()) {
+            head_ = (head_ + 1) & mask_;
+            --size_;
+        }
+        buf_[(head_ + size_) & mask_] = p;
+        ++size_;
+    }
+
+    void pop_front() {
+        head_ = (head_ + 1) & mask_;
+        --size_;
+    }
+
+private:
+    std::vector<PathSample> buf_;
+    std::uint32_t mask_ = 0;
+    std::uint32_t head_ = 0;
+    std::uint32_t size_ = 0;
+};
+
+// Movement case contributions of one actor and the inputs they were built from (see SpeedCore::MovementTarget)
+struct CaseCache {
+    const void* location = nullptr;  // place locMod was resolved for
+    std::uint32_t epoch = 0;  // settings generation, 0 = never built
+    std::uint8_t dirty = 0;   // SpeedCore::kDirty* bits set by events
+    std::uint8_t key = 0;     // state flags of state
+    float state = 0.0f;       // case base with location / weather / sprint
+    float armor = 0.0f;
+    float vitals = 0.0f;
+    float scale = 0.0f;
+    float locMod = 0.0f;
+    float weatherMod = 0.0f;
+    float scaleIn = 0.0f;
+    std::array<float, 6> vitalsIn{};  // health, max, stamina, max, magicka, max
+};
+
+// Worn armor weight of one actor, read once and kept until an equip marks it stale (SpeedCore::ArmorOf)
+struct ArmorCache {
+    float sum = 0.0f;
+    float max = 0.0f;
+    bool valid = false;
+    bool equipPending = false;  // equip event seen, the next gather invalidates (SpeedCore::MarkEquipChanged)
+};
+
+// Attack speed inputs and target of the last update that wrote (see SpeedCore::UpdateAttackSpeed)
+struct AttackCache {
+    struct Inputs {
+        std::uint64_t epoch = 0;  // Settings::Snapshot::epoch
+        bool active = false;      // enabled, not in beast form, drawn if required
+        float weapon = 0.0f;
+        float armor = 0.0f;
+        float scale = 1.0f;
+        bool operator==(const Inputs&) const = default;
+    } in;
+    float target = 0.0f;
+    float weapon = 0.0f;       // equipped weight as last read
+    bool weaponValid = false;  // read since the last equip
+    bool valid = false;
+};
+
+// Beast form result of one actor, only recomputed when its race or the settings change (see SpeedCore::BeastForm)
+struct RaceCache {
+    const void* race = nullptr;
+    std::uint64_t epoch = 0;  // Settings::Snapshot::epoch it was computed with
+    bool valid = false;
+    bool beast = false;
+};
+
+// Dynamic Wetness sweat of one actor and what was last handed to it (see SpeedCore::PublishSweat)
+struct SweatState {
+    float intensity = 0.0f;  // smoothed towards the slope target
+    float sent = 0.0f;
+    std::uint64_t sentMs = 0;
+    bool outstanding = false;  // a mask is set and was not cleared since
+};
+
+// Slot map for per-actor controller state.
+// Every tracked actor owns one stable slot index, the hot fields live in parallel arrays indexed by that slot.
+// Slot 0 is reserved for the player and never released. Released slots go to a free list and get reused.
+// References into the arrays stay valid until the next Acquire() of an actor that has no slot yet.
+class ActorStateTable {
+public:
+    using Slot = std::uint32_t;
+
+    static constexpr Slot kPlayerSlot = 0;
+    static constexpr Slot kNoSlot = 0xFFFFFFFFu;
+    static constexpr std::uint32_t kPlayerFormID = 0x14;
+
+    // lodTier of a slot the tick has not classified yet (acquired by an event), = SpeedCore::LodTier::Out so the
+    // slope pass skips it and the first classification counts as entering its tier
+    static constexpr std::uint8_t kLodUnclassified = 3;
+
+    // refreshState values (see SpeedCore::QueueRefresh)
+    static constexpr std::uint8_t kRefreshQueued = 1;  // in the refresh queue of the current tick
+    static constexpr std::uint8_t kRefreshOwed = 2;    // held back by the minimum interval, queued by the next flush
+
+    ActorStateTable() {
+        Reserve(256);
+        Grow();  // slot 0 = player
+        formID[kPlayerSlot] = kPlayerFormID;
+        live[kPlayerSlot] = 1;
+    }
+
+    Slot Find(std::uint32_t id) const {
+        if (id == kPlayerFormID) return kPlayerSlot;
+        if (id == memoID_) return memoSlot_;
+        auto it = index_.find(id);
+        if (it == index_.end()) return kNoSlot;
+        memoID_ = id;
+        memoSlot_ = it->second;
+        return it->second;
+    }
+
+    Slot Acquire(std::uint32_t id) {
+        if (Slot s = Find(id); s != kNoSlot) return s;
+
+        Slot s;
+        if (!free_.empty()) {
+            s = free_.back();
+            free_.pop_back();
+        } else {
+            s = static_cast<Slot>(formID.size());
+            Grow();
+        }
+        formID[s] = id;
+        live[s] = 1;
+        index_.emplace(id, s);
+        memoID_ = id;
+        memoSlot_ = s;
+        return s;
+    }
+
+    // O(1): drop the index entry, reset the slot and push it onto the free list
+    void Release(std::uint32_t id) {
+        if (id == kPlayerFormID) return;
+        auto it = index_.find(id);
+        if (it == index_.end()) return;
+        const Slot s = it->second;
+        index_.erase(it);
+        if (memoID_ == id) ForgetMemo();
+        ResetSlot(s);
+        live[s] = 0;
+        free_.push_back(s);
+    }
+
+    void ReleaseAllNPCs() {
+        for (Slot s = 1; s < static_cast<Slot>(formID.size()); ++s) {
+            if (!live[s]) continue;
+            ResetSlot(s);
+            live[s] = 0;
+            free_.push_back(s);
+        }
+        index_.clear();
+        ForgetMemo();
+    }
+
+    void ResetSlot(Slot s) {
+        moveDelta[s] = 0.0f;
+        attackDelta[s] = 0.0f;
+        diagDelta[s] = 0.0f;
+        diagResidual[s] = 0.0f;
+        slopeDelta[s] = 0.0f;
+        slopeResidual[s] = 0.0f;
+        scaleDelta[s] = 0.0f;
+        scaleResidual[s] = 0.0f;
+        lastApplyMs[s] = 0;
+        lastSlopeMs[s] = 0;
+        lastRefreshMs[s] = 0;
+        refreshState[s] = 0;
+        prevSprinting[s] = 0;
+        prevSneak[s] = 0;
+        prevDrawn[s] = 0;
+        prevCombat[s] = 0;
+        lodTier[s] = kLodUnclassified;
+        lodCountdown[s] = 0;
+        caseCache[s] = CaseCache{};
+        armorCache[s] = ArmorCache{};
+        attackCache[s] = AttackCache{};
+        raceCache[s] = RaceCache{};
+        sweat[s] = SweatState{};
+        path[s].clear();
+    }
+
+    std::size_t TrackedNPCs() const { return index_.size(); }
+    std::size_t Capacity() const { return formID.size(); }
+
+    // Per-slot state (index = Slot)
+    std::vector<std::uint32_t> formID;
+    std::vector<std::uint8_t> live;
+
+    // SpeedMult ledger, everything we added on top of the engine value
+    std::vector<float> moveDelta;
+    std::vector<float> attackDelta;  // kWeaponSpeedMult
+    std::vector<float> diagDelta;
+    std::vector<float> diagResidual;
+    std::vector<float> slopeDelta;
+    std::vector<float> slopeResidual;
+    std::vector<float> scaleDelta;
+    std::vector<float> scaleResidual;
+
+    std::vector<std::uint64_t> lastApplyMs;
+    std::vector<std::uint64_t> lastSlopeMs;
+    std::vector<std::uint64_t> lastRefreshMs;
+    std::vector<std::uint8_t> refreshState;
+
+    std::vector<std::uint8_t> prevSprinting;
+    std::vector<std::uint8_t> prevSneak;
+    std::vector<std::uint8_t> prevDrawn;
+    std::vector<std::uint8_t> prevCombat;
+
+    std::vector<std::uint8_t> lodTier;       // SpeedCore::LodTier
+    std::vector<std::uint8_t> lodCountdown;  // ticks until the next mid tier update
+
+    std::vector<CaseCache> caseCache;  // one record, MovementTarget reads all of it at once
+    std::vector<ArmorCache> armorCache;
+    std::vector<AttackCache> attackCache;
+    std::vector<RaceCache> raceCache;
+    std::vector<SweatState> sweat;
+
+    std::vector<PathRing> path;  // sized lazily on first sample (see SpeedCore::PushPathSample)
+
+private:
+    void ForgetMemo() {
+        memoID_ = 0;
+        memoSlot_ = kNoSlot;
+    }
+
+    void Reserve(std::size_t n) {
+        formID.reserve(n);
+        live.reserve(n);
+        moveDelta.reserve(n);
+        attackDelta.reserve(n);
+        diagDelta.reserve(n);
+        diagResidual.reserve(n);
+        slopeDelta.reserve(n);
+        slopeResidual.reserve(n);
+        scaleDelta.reserve(n);
+        scaleResidual.reserve(n);
+        lastApplyMs.reserve(n);
+        lastSlopeMs.reserve(n);
+        lastRefreshMs.reserve(n);
+        refreshState.reserve(n);
+        prevSprinting.reserve(n);
+        prevSneak.reserve(n);
+        prevDrawn.reserve(n);
+        prevCombat.reserve(n);
+        lodTier.reserve(n);
+        lodCountdown.reserve(n);
+        caseCache.reserve(n);
+        armorCache.reserve(n);
+        attackCache.reserve(n);
+        raceCache.reserve(n);
+        sweat.reserve(n);
+        path.reserve(n);
+        index_.reserve(n);
+    }
+
+    void Grow() {
+        formID.push_back(0);
+        live.push_back(0);
+        moveDelta.push_back(0.0f);
+        attackDelta.push_back(0.0f);
+        diagDelta.push_back(0.0f);
+        diagResidual.push_back(0.0f);
+        slopeDelta.push_back(0.0f);
+        slopeResidual.push_back(0.0f);
+        scaleDelta.push_back(0.0f);
+        scaleResidual.push_back(0.0f);
+        lastApplyMs.push_back(0);
+        lastSlopeMs.push_back(0);
+        lastRefreshMs.push_back(0);
+        refreshState.push_back(0);
+        prevSprinting.push_back(0);
+        prevSneak.push_back(0);
+        prevDrawn.push_back(0);
+        prevCombat.push_back(0);
+        lodTier.push_back(kLodUnclassified);
+        lodCountdown.push_back(0);
+        caseCache.emplace_back();
+        armorCache.emplace_back();
+        attackCache.emplace_back();
+        raceCache.emplace_back();
+        sweat.emplace_back();
+        path.emplace_back();
+    }
+
+    std::unordered_map<std::uint32_t, Slot> index_;
+    std::vector<Slot> free_;
+
+    // One-entry lookup cache: a single ApplyFor hits the same actor many times in a row
+    mutable std::uint32_t memoID_ = 0;
+    mutable Slot memoSlot_ = kNoSlot;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SmoothingFilter.h"
+
+// Batch versions of the per-actor MovementMath kernels for the NPC pass: contiguous input arrays in, one result
+// per actor out. On x64 they run 4 (SSE2) or 8 (AVX2, picked at runtime) actors per instruction, everywhere else
+// (or with DSC_SIMD=0) they loop over the scalar kernels.
+//
+// Tolerance against the scalar kernels: exp/atan are polynomial approximations (Cephes), so
+//   Smooth          |batch - scalar| <= kSmoothTolerance * |target - prev| (measured worst case ~2.3e-5)
+//   SlopeDeg        |batch - scalar| <= kSlopeToleranceDeg (measured worst case ~8e-6)
+//   DiagonalFactor  bit-identical (only sqrt/div/min/max, all exactly rounded)
+// Tails shorter than a vector go through the same vector code, so a result never depends on its position.
+#ifndef DSC_SIMD
+    #define DSC_SIMD 1
+#endif
+
+namespace BatchMath {
+    enum class Isa : std::uint8_t { Scalar, SSE2, AVX2 };
+
+    inline constexpr float kSmoothTolerance = 5e-5f;
+    inline constexpr float kSlopeToleranceDeg = 1e-4f;
+
+    // Best instruction set this build and CPU support, unless overridden by ForceIsa
+    Isa ActiveIsa();
+    const char* IsaName(Isa isa);
+    // Benchmarks only: pin an instruction set (clamped to what is available), returns the one in effect
+    Isa ForceIsa(Isa isa);
+
+    // out[i] = filter.Step(prev[i], target[i], dtSec[i]), one policy dispatch per call
+    void Smooth(const MovementMath::SmoothingFilter& filter, const float* prev, const float* target,
+                const float* dtSec, float* out, std::size_t n);
+
+    // out[i] = MovementMath::DiagonalFactor(x[i], y[i])
+    void DiagonalFactor(const float* x, const float* y, float* out, std::size_t n);
+
+    // out[i] = clamp(atan2(dz[i], dxy[i]) in degrees, -85, 85), dxy > 0 (see MovementMath::PathSlopeRef)
+    void SlopeDeg(const float* dz, const float* dxy, float* out, std::size_t n);
+}
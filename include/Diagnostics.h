@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Hot-path timers and counters for the Diagnostics menu page.
+// Writers bump fixed log-scale histograms with a relaxed load + store, not a locked add: they all run on the game
+// thread and the UI only reads, so nothing ever blocks. A Reset() from the UI can lose the adds in flight.
+// Build with DSC_DIAGNOSTICS=0 to compile every DSC_PROFILE_SCOPE / DSC_COUNT away.
+#ifndef DSC_DIAGNOSTICS
+    #define DSC_DIAGNOSTICS 1
+#endif
+
+namespace Diag {
+    enum class Stage : std::uint8_t {
+        Apply,
+        ApplyFor,
+        CaseToDelta,
+        SlopePenalty,
+        DiagonalPenalty,
+        ForceSpeedRefresh,
+        AttackSpeed,
+        kCount
+    };
+
+    enum class Counter : std::uint8_t { AvWrites, ActorsProcessed, Refreshes, kCount };
+
+    inline constexpr std::size_t kStageCount = static_cast<std::size_t>(Stage::kCount);
+    inline constexpr std::size_t kCounterCount = static_cast<std::size_t>(Counter::kCount);
+
+    const char* StageName(Stage s);
+    const char* CounterName(Counter c);
+
+    // 8 exact buckets below 8 ns, then 4 buckets per power of two up to ~18 min
+    inline constexpr std::size_t kBuckets = 160;
+
+    struct StageStats {
+        std::uint64_t calls = 0;
+        std::uint64_t timed = 0;  // calls that went into the histogram
+        double perSec = 0.0;
+        double meanUs = 0.0;
+        double p50Us = 0.0;
+        double p95Us = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+    struct CounterStats {
+        std::uint64_t total = 0;
+        double perSec = 0.0;
+    };
+
+    struct Snapshot {
+        double seconds = 0.0;  // since the last reset
+        std::array<StageStats, kStageCount> stages{};
+        std::array<CounterStats, kCounterCount> counters{};
+    };
+
+    // Per-actor stages run thousands of times per second, only every Nth call is timed (all calls are counted)
+    constexpr std::uint32_t SampleEvery(Stage s) {
+        switch (s) {
+            case Stage::ApplyFor:
+            case Stage::CaseToDelta:
+            case Stage::SlopePenalty:
+            case Stage::DiagonalPenalty:
+                return 16;
+            default:
+                return 1;
+        }
+    }
+
+    bool CountCall(Stage s);  // true if this call should be timed
+    void Record(Stage s, std::uint64_t ns);
+    void Count(Counter c, std::uint64_t n = 1);
+    Snapshot Take();
+    void Reset();
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage s) : stage_(s), timed_(CountCall(s)) {
+            if (timed_) t0_ = std::chrono::steady_clock::now();
+        }
+        ~ScopedTimer() {
+            if (!timed_) return;
+            const auto dt = std::chrono::steady_clock::now() - t0_;
+            Record(stage_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count()));
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Stage stage_;
+        bool timed_;
+        std::chrono::steady_clock::time_point t0_{};
+    };
+}
+
+#if DSC_DIAGNOSTICS
+    #define DSC_DIAG_CONCAT_(a, b) a##b
+    #define DSC_DIAG_CONCAT(a, b) DSC_DIAG_CONCAT_(a, b)
+    #define DSC_PROFILE_SCOPE(stage) const Diag::ScopedTimer DSC_DIAG_CONCAT(dscTimer_, __LINE__){stage}
+    #define DSC_COUNT(counter, n) Diag::Count(counter, n)
+#else
+    #define DSC_PROFILE_SCOPE(stage) ((void)0)
+    #define DSC_COUNT(counter, n) ((void)0)
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Settings.h"
+
+// Location / weather rules from Settings, resolved to FormID-keyed tables.
+// The FormSpecs (plugin name + local id) are looked up in TESDataHandler once per settings change instead of once
+// per rule per actor per tick. Location rules are flattened per BGSLocation (specific, keywords, then parentLoc
+// chain), so both lookups are a single probe no matter how many rules are configured. The beast form races
+// (editor IDs or FormSpecs) end up in a FormID set the same way.
+class FormRuleIndex {
+public:
+    // Rebuild if the snapshot's rules have another revision than the last build. Cheap when nothing changed.
+    void EnsureCurrent(const Settings::FormRules& rules);
+    void Rebuild(const Settings::FormRules& rules);
+
+    std::optional<float> LocationValue(const RE::BGSLocation* loc) const;
+    std::optional<float> WeatherValue(const RE::TESWeather* w) const;
+    bool IsBeastRace(const RE::TESRace* r) const { return r && beastRaces_.contains(r->GetFormID()); }
+
+    std::size_t ResolvedCount() const { return location_.size() + weather_.size(); }
+
+private:
+    struct Rule {
+        float value = 0.0f;
+        std::uint32_t order = 0;  // position in the settings list, the first matching rule wins
+    };
+
+    static constexpr int kMaxParentDepth = 16;
+
+    static std::optional<float> ResolveChain(const RE::BGSLocation* loc,
+                                             const std::unordered_map<RE::FormID, Rule>& specific,
+                                             const std::unordered_map<RE::FormID, Rule>& keyword);
+    void ResolveBeastRaces(const std::vector<std::string>& entries);
+
+    std::unordered_map<RE::FormID, float> location_;  // only locations that end up with a modifier
+    std::unordered_map<RE::FormID, float> weather_;
+    std::unordered_set<RE::FormID> beastRaces_;
+
+    std::uint32_t builtRevision_ = 0;
+    bool built_ = false;
+};
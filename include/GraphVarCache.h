@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+// Which of the alternative animation graph variable names (MoveX vs SpeedSide vs Strafe, IsSprinting vs bSprint, ...)
+// a behavior graph actually has, so reads and writes only touch those instead of probing every name each tick.
+// Keyed by the race's behavior graph project for the actor's sex: races sharing a project share one entry, and a
+// race switch (werewolf, vampire lord) or another graph is simply another key. Actors without loaded 3D are probed
+// again on the next call instead of caching "nothing exists". Game thread only.
+class GraphVarCache {
+public:
+    // Variables of the first axis pair the graph has, false without one (a missing half reads as 0)
+    bool GetMoveAxes(const RE::Actor* a, float& outX, float& outY);
+    // Any of IsSprinting / bIsSprinting / bSprint is true
+    bool IsSprinting(const RE::Actor* a);
+    // Any of the werewolf / vampire lord flags is true
+    bool HasBeastFlag(const RE::Actor* a);
+    // Writes every anim speed variable the graph has, false if it has none
+    bool SetAnimSpeed(RE::Actor* a, float v);
+
+    void Clear() { bindings_.clear(); }
+    std::size_t Size() const { return bindings_.size(); }
+
+private:
+    // One bit per name in the matching list of GraphVarCache.cpp
+    struct Binding {
+        std::int8_t axes = -1;  // index of the axis pair, -1 none
+        std::uint8_t sprint = 0;
+        std::uint8_t beast = 0;
+        std::uint8_t animSpeed = 0;
+    };
+
+    const Binding* Find(const RE::Actor* a);
+
+    std::unordered_map<const void*, Binding> bindings_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks the delay until the next heartbeat from the work that is still outstanding.
+// While anything converges (smoothing/slope writes, pending refresh, post-load nudges, sprint anim, movement)
+// the heartbeat runs at the active cadence. After kSettleTicks quiet ticks in a row it drops to the idle cadence,
+// event sinks pull it back via SpeedController::WakeHeartbeat().
+class HeartbeatScheduler {
+public:
+    static constexpr std::uint32_t kActiveMs = 33;
+    static constexpr std::uint32_t kSettleTicks = 30;  // ~1 s of nothing to do before going idle
+
+    struct Work {
+        bool coreActive = false;      // SpeedCore wrote something or saw movement/state flips
+        bool pendingRefresh = false;  // ForceSpeedRefresh still owed
+        bool postLoadNudges = false;  // post-load refresh nudges left
+        bool sprintAnim = false;      // sprint anim rate not settled yet
+        bool Any() const { return coreActive || pendingRefresh || postLoadNudges || sprintAnim; }
+    };
+
+    // idleMs <= kActiveMs disables the idle cadence
+    std::uint32_t Next(const Work& w, int idleMs) {
+        if (w.Any()) {
+            quietTicks_ = 0;
+            return kActiveMs;
+        }
+        if (quietTicks_ < kSettleTicks) ++quietTicks_;
+        if (idleMs <= static_cast<int>(kActiveMs) || quietTicks_ < kSettleTicks) return kActiveMs;
+        return static_cast<std::uint32_t>(idleMs);
+    }
+
+    void Reset() { quietTicks_ = 0; }
+    bool Idle() const { return quietTicks_ >= kSettleTicks; }
+
+private:
+    std::uint32_t quietTicks_ = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// User events and key codes of the input sink mapped to what they do.
+// Built once per binding change with every user event name interned up front, so the sink compares BSFixedString
+// data pointers instead of interning a string per button event. A handful of entries, a linear pointer scan is
+// cheaper than hashing. An action can have several bindings, a key binding can be a chord: all of its keys held,
+// fires on the press of the last one ("42+19" = LShift + R).
+class InputActionMap {
+public:
+    using Actions = std::uint8_t;
+    static constexpr Actions kForward = 1 << 0;
+    static constexpr Actions kBack = 1 << 1;
+    static constexpr Actions kStrafeLeft = 1 << 2;
+    static constexpr Actions kStrafeRight = 1 << 3;
+    static constexpr Actions kSprint = 1 << 4;
+    static constexpr Actions kToggleJogging = 1 << 5;
+
+    struct Config {
+        std::string sprintEvents;  // comma separated user event names
+        std::string toggleEvents;
+        std::uint32_t toggleKey = 0;  // 0 = none
+        std::string toggleChords;     // comma separated, keys joined by '+'
+    };
+
+    static InputActionMap Build(const Config& c);
+
+    // Chord keys currently held, one bit per tracked key. Owned by the caller, starts at 0 for every new map.
+    using KeyState = std::uint32_t;
+
+    // Actions bound to the user event, 0 if none
+    Actions ForEvent(const RE::BSFixedString& userEvent) const {
+        const char* p = userEvent.data();
+        if (!p) return 0;
+        for (const auto& e : events_) {
+            if (e.name.data() == p) return e.actions;
+        }
+        return 0;
+    }
+
+    // Updates the held chord keys and returns the key bindings completed by this press
+    Actions ForKey(std::uint32_t idCode, bool down, bool press, KeyState& held) const;
+
+private:
+    static constexpr std::size_t kMaxChordKeys = 4;
+    static constexpr std::size_t kMaxTrackedKeys = 32;  // bits in KeyState
+
+    struct EventBinding {
+        RE::BSFixedString name;  // keeps the pool entry alive, compared by data()
+        Actions actions = 0;
+    };
+    struct KeyBinding {
+        std::array<std::uint32_t, kMaxChordKeys> keys{};  // trigger key last
+        std::uint8_t count = 0;
+        Actions actions = 0;
+    };
+
+    void BindEvent(std::string_view name, Actions a);
+    void BindEvents(const std::string& list, Actions a);
+    void BindKeys(const std::uint32_t* keys, std::size_t n, Actions a);
+    int TrackedIndex(std::uint32_t code) const;
+
+    std::vector<EventBinding> events_;
+    std::vector<KeyBinding> keys_;
+    std::vector<std::uint32_t> tracked_;  // keys that are part of a chord, index = KeyState bit
+};
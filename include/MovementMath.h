@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "ActorStateTable.h"
+#include "Settings.h"
+#include "SmoothingFilter.h"
+
+// Pure math kernels of the controller. No engine types, no Settings reads unless stated.
+namespace MovementMath {
+    // One-shot forms of the SmoothingFilter policies. Hot loops build the filter once and reuse it.
+    inline float ExpoLerp(float prev, float target, float dt, float tau) {
+        return ExpoPolicy::FromTauSec(tau).Step(prev, target, dt);
+    }
+
+    inline float RateTowards(float prev, float target, float dt, float ratePerSec) {
+        return RatePolicy::Towards(ratePerSec).Step(prev, target, dt);
+    }
+
+    inline float SmoothExpo(float prev, float target, float dtSec, float halfLifeMs) {
+        return ExpoPolicy::FromHalfLifeMs(halfLifeMs).Step(prev, target, dtSec);
+    }
+
+    inline float SmoothRate(float prev, float target, float dtSec, float maxPerSec) {
+        return RatePolicy::Limit(maxPerSec).Step(prev, target, dtSec);
+    }
+
+    inline float SmoothCombined(float prev, float target, float dtSec, Settings::SmoothingMode mode, float halfLifeMs,
+                                float maxPerSec) {
+        return SmoothingFilter::Movement(mode, halfLifeMs, maxPerSec).Step(prev, target, dtSec);
+    }
+
+    // Sprint-animation smoothing as configured in c
+    inline float SmoothSprintAnim(const Settings::Snapshot& c, float prev, float target, float dt) {
+        SmoothingFilter f;
+        f.SyncSprintAnim(c);
+        return f.Step(prev, target, dt);
+    }
+
+    // f = max(|x|,|y|) / sqrt(x^2 + y^2)   (<= 1), 1 if there is no input
+    inline float DiagonalFactor(float inX, float inY) {
+        const float ax = std::fabs(inX), ay = std::fabs(inY);
+        const float mag = std::sqrt(inX * inX + inY * inY);
+        const float maxc = std::max(ax, ay);
+        if (mag <= 1e-4f || maxc <= 0.0f) return 1.0f;
+        return std::min(1.0f, maxc / mag);
+    }
+
+    // Stick deadzone (per axis, or on the whole stick if radial) and optional rounding to step, in place
+    inline void ShapeStickInput(float& x, float& y, float deadzone, bool radial, float step) {
+        if (radial) {
+            if (x * x + y * y < deadzone * deadzone) x = y = 0.0f;
+        } else {
+            if (std::fabs(x) < deadzone) x = 0.0f;
+            if (std::fabs(y) < deadzone) y = 0.0f;
+        }
+        if (step > 0.0f) {
+            x = std::clamp(std::round(x / step) * step, -1.0f, 1.0f);
+            y = std::clamp(std::round(y / step) * step, -1.0f, 1.0f);
+        }
+    }
+
+    // diagFactor = DiagonalFactor(inX, inY)
+    inline float PredictDiagonalPenalty(float curSM, float floor, float diagFactor, bool sprinting) {
+        const float headroom = std::max(0.0f, curSM - floor);
+        float penalty = headroom * (diagFactor - 1.0f);
+        if (sprinting) penalty *= 0.5f;
+        return penalty;
+    }
+
+    inline float PredictDiagonalPenalty(float curSM, float floor, float inX, float inY, bool sprinting) {
+        return PredictDiagonalPenalty(curSM, floor, DiagonalFactor(inX, inY), sprinting);
+    }
+
+    // Linear ramp below the threshold, result is <= 0 (SpeedMult points)
+    inline float LinearVitalPenaltyPct(float cur, float maxv, float thrPct, float reducePct, float smoothWidthPct) {
+        if (maxv <= 1e-3f) return 0.0f;
+
+        const float pct = std::clamp(cur / maxv * 100.0f, 0.0f, 100.0f);
+        const float w = std::max(0.0f, smoothWidthPct);
+
+        float factor = 0.0f;
+        if (pct <= thrPct - w)
+            factor = 1.0f;
+        else if (pct < thrPct && w > 0.f)
+            factor = (thrPct - pct) / w;
+        else
+            factor = 0.0f;
+
+        return -reducePct * std::clamp(factor, 0.0f, 1.0f);
+    }
+
+    inline float ArmorMoveDelta(float armorWeight, float slopeSM, float pivot, float lo, float hi) {
+        float d = slopeSM * (armorWeight - pivot);
+        if (lo <= hi) {
+            d = std::clamp(d, lo, hi);
+        } else {
+            d = std::clamp(d, hi, lo);
+        }
+        return d;
+    }
+
+    struct AttackParams {
+        float base = 1.0f;
+        float weightPivot = 10.0f;
+        float weightSlope = -0.03f;
+        bool useScale = false;
+        float scaleSlope = 0.25f;
+        float minMult = 0.6f;
+        float maxMult = 1.8f;
+        bool useArmor = false;
+        float armorSlope = -0.01f;
+        float armorPivot = 20.0f;
+    };
+
+    inline float AttackSpeedTarget(const AttackParams& p, float weaponWeight, float scale, float armorWeight) {
+        float target = p.base + p.weightSlope * (weaponWeight - p.weightPivot) +
+                       (p.useScale ? (p.scaleSlope * (scale - 1.0f)) : 0.0f);
+        target = std::max(p.minMult, std::min(p.maxMult, target));
+        if (p.useArmor) {
+            target += p.armorSlope * (armorWeight - p.armorPivot);
+        }
+        return target;
+    }
+
+    // Rise and XY run between the newest sample and the last one at least lookbackUnits (XY) behind it.
+    // sxy is monotonic, so the reference sample is found by binary search. outDxy is >= 1e-3.
+    inline bool PathSlopeRef(const PathRing& q, float lookbackUnits, float& outDz, float& outDxy) {
+        if (q.size() < 2) return false;
+
+        const auto& cur = q.back();
+        const float wantSxy = std::max(0.f, cur.sxy - std::max(lookbackUnits, 0.0f));
+
+        // First index with sxy > wantSxy, the reference is the one before it (or the oldest sample)
+        std::size_t lo = 0, hi = q.size();
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (q[mid].sxy <= wantSxy)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        const PathSample& ref = (lo > 0) ? q[lo - 1] : q.front();
+
+        outDxy = std::max(1e-3f, cur.sxy - ref.sxy);
+        outDz = cur.z - ref.z;
+        return true;
+    }
+
+    inline float SlopeDegFrom(float dz, float dxy) {
+        return std::clamp(std::atan2(dz, dxy) * 57.29578f, -85.0f, 85.0f);
+    }
+
+    inline bool ComputePathSlopeDeg(const PathRing& q, float lookbackUnits, float& outDeg) {
+        float dz = 0.0f, dxy = 0.0f;
+        if (!PathSlopeRef(q, lookbackUnits, dz, dxy)) return false;
+        outDeg = SlopeDegFrom(dz, dxy);
+        return true;
+    }
+}
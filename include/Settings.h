@@ -1,10 +1,12 @@
 #pragma once
 #include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <optional>
-
-// Get nlohmann/json from: https://github.com/nlohmann/json
-#include "nlohmann/json.hpp"
+#include <string>
+#include <vector>
 
 struct Settings {
     enum class SmoothingMode { Exponential = 0, RateLimit = 1, ExpoThenRate = 2 };
@@ -44,6 +46,10 @@ struct Settings {
     inline static std::atomic<bool> ignoreBeastForms{true};
     inline static std::atomic<bool> enableDiagonalSpeedFix{false};
     inline static std::atomic<bool> enableDiagonalSpeedFixForNPCs{false};
+    // Player stick input shaping before the diagonal fix sees it
+    static inline std::atomic<float> inputDeadzone{0.12f};
+    static inline std::atomic<bool> inputRadialDeadzone{false};  // whole stick below the deadzone, else per axis
+    static inline std::atomic<float> inputAxisStep{0.0f};        // round each axis to this step, 0 = off
     // Movement speed scaling fix for the player
     static inline std::atomic<bool> scaleCompEnabled{false};
     static inline std::atomic<bool> scaleCompOnlyBelowOne{true};  // Only apply if player scale < 1.0
@@ -58,6 +64,7 @@ struct Settings {
     static inline std::atomic<bool> noReductionInCombat{true};
     static inline std::atomic<int> toggleSpeedKey{269};
     static inline std::string toggleSpeedEvent{"Shout"};
+    static inline std::string toggleSpeedChords;  // extra toggle keys, "42+19, 29+47" (held keys first)
     static inline std::string sprintEventName{"Sprint"};
 
     // Attack speed scaling
@@ -96,9 +103,25 @@ struct Settings {
     static inline std::atomic<float> armorWeightSlopeAtk{-0.010f};
 
     static inline std::atomic<int> eventDebounceMs{10};
+    static inline std::atomic<int> heartbeatIdleMs{250};  // Heartbeat interval once everything settled, <= 33 = always active
+    static inline std::atomic<int> refreshMinIntervalMs{25};      // Min time between two speed refreshes of the player
+    static inline std::atomic<int> npcRefreshMinIntervalMs{100};  // Same per NPC
     static inline std::atomic<int> npcRadius{2048};  // Max distance for NPCs is 16384, 0 = All NPCs (Disable radius check)
     static inline std::atomic<float> npcPercentOfPlayer{50.0f};  // NPCs move at least this percent of player speed, because NPCs are slower than players
 
+    // NPC update tiers inside npcRadius: near = full update every tick, mid = movement case every N ticks,
+    // far = deltas held, re-evaluated on sprint/sneak/drawn/combat flips only
+    static inline std::atomic<bool> npcLodEnabled{true};
+    static inline std::atomic<int> npcLodNearRadius{1024};
+    static inline std::atomic<int> npcLodMidRadius{1536};
+    static inline std::atomic<int> npcLodMidInterval{4};   // Ticks between mid tier updates
+    static inline std::atomic<int> npcLodHysteresis{128};  // Units past a tier edge before an actor switches
+
+    // NPC pass time slicing: stop after this many microseconds and continue next tick (0 = no budget),
+    // but always cover all NPCs at least once per npcMaxStaleMs
+    static inline std::atomic<int> npcBudgetUs{1500};
+    static inline std::atomic<int> npcMaxStaleMs{250};
+
     static inline std::atomic<bool> healthEnabled{false};
     static inline std::atomic<float> healthThresholdPct{30.0f};
     static inline std::atomic<float> healthReducePct{20.0f};
@@ -131,6 +154,7 @@ struct Settings {
         std::string plugin;
         std::uint32_t id = 0;
         float value = 0.f;
+        bool operator==(const FormSpec&) const = default;
     };
 
     static inline std::vector<FormSpec> reduceInLocationType;      // BGSKeyword*
@@ -152,8 +176,157 @@ struct Settings {
     static inline std::vector<FormSpec> reduceInWeatherSpecific;  // TESWeather*
     static inline std::atomic<bool> weatherIgnoreInterior{true};
 
+    // Races that count as beast form (ignoreBeastForms), editor ID or "Plugin.esp|0xID" for races without one
+    static inline std::vector<std::string> beastRaces{"WerewolfBeastRace", "DLC1VampireBeastRace"};
+
+    // Bumped whenever one of the form lists above changes, consumers rebuild their resolved lookups on change
+    static inline std::atomic<std::uint32_t> formRulesRevision{0};
+    static void MarkFormRulesChanged() { formRulesRevision.fetch_add(1, std::memory_order_relaxed); }
+
+    // Immutable copy of everything above. The statics are the writer side (UI / JSON), Publish() copies them into
+    // a new snapshot and swaps it in atomically. Readers take one with Current() per tick, so every read after that
+    // is a plain load and the rule lists can never be seen half-edited.
+    struct FormRules {
+        std::vector<FormSpec> locationType;
+        std::vector<FormSpec> locationSpecific;
+        std::vector<FormSpec> weatherSpecific;
+        std::vector<std::string> beastRaces;
+        std::uint32_t revision = 0;  // formRulesRevision at capture
+    };
+
+    struct Snapshot {
+        // Same names and meaning as the statics above
+        bool slopeEnabled{};
+        bool slopeAffectsNPCs{};
+        float slopeUphillPerDeg{};
+        float slopeDownhillPerDeg{};
+        float slopeMaxAbs{};
+        float slopeTau{};
+        int slopeMethod{};
+        float slopeLookbackUnits{};
+        float slopeMaxHistorySec{};
+        float slopeMinXYPerFrame{};
+        int slopeMedianN{};
+        bool slopeClampEnabled{};
+        float slopeMinFinal{};
+        float slopeMaxFinal{};
+        float minFinalSpeedMult{};
+        bool smoothingEnabled{};
+        bool smoothingAffectsNPCs{};
+        bool smoothingBypassOnStateChange{};
+        SmoothingMode smoothingMode{};
+        float smoothingHalfLifeMs{};
+        float smoothingMaxChangePerSecond{};
+        bool enableSpeedScalingForNPCs{};
+        bool ignoreBeastForms{};
+        bool enableDiagonalSpeedFix{};
+        bool enableDiagonalSpeedFixForNPCs{};
+        float inputDeadzone{};
+        bool inputRadialDeadzone{};
+        float inputAxisStep{};
+        bool scaleCompEnabled{};
+        bool scaleCompOnlyBelowOne{};
+        float scaleCompPerUnitSM{};
+        ScaleCompMode scaleCompMode{};
+        float reduceOutOfCombat{};
+        float reduceJoggingOutOfCombat{};
+        float reduceDrawn{};
+        float reduceSneak{};
+        float increaseSprinting{};
+        bool noReductionInCombat{};
+        int toggleSpeedKey{};
+        std::string toggleSpeedEvent{};
+        std::string toggleSpeedChords{};
+        std::string sprintEventName{};
+        bool attackSpeedEnabled{};
+        bool attackOnlyWhenDrawn{};
+        bool sprintAffectsCombat{};
+        float attackBase{};
+        float weightPivot{};
+        float weightSlope{};
+        bool usePlayerScale{};
+        float scaleSlope{};
+        float minAttackMult{};
+        float maxAttackMult{};
+        bool syncSprintAnimToSpeed{};
+        bool onlySlowDown{};
+        float sprintAnimMin{};
+        float sprintAnimMax{};
+        bool sprintAnimOwnSmoothing{};
+        int sprintAnimSmoothingMode{};
+        float sprintAnimTau{};
+        float sprintAnimRatePerSec{};
+        bool armorAffectsMovement{};
+        bool armorAffectsAttackSpeed{};
+        bool useMaxArmorWeight{};
+        float armorWeightPivot{};
+        float armorWeightSlopeSM{};
+        float armorMoveMin{};
+        float armorMoveMax{};
+        float armorWeightSlopeAtk{};
+        int eventDebounceMs{};
+        int heartbeatIdleMs{};
+        int refreshMinIntervalMs{};
+        int npcRefreshMinIntervalMs{};
+        int npcRadius{};
+        float npcPercentOfPlayer{};
+        bool npcLodEnabled{};
+        int npcLodNearRadius{};
+        int npcLodMidRadius{};
+        int npcLodMidInterval{};
+        int npcLodHysteresis{};
+        int npcBudgetUs{};
+        int npcMaxStaleMs{};
+        bool healthEnabled{};
+        float healthThresholdPct{};
+        float healthReducePct{};
+        float healthSmoothWidthPct{};
+        bool staminaEnabled{};
+        float staminaThresholdPct{};
+        float staminaReducePct{};
+        float staminaSmoothWidthPct{};
+        bool magickaEnabled{};
+        float magickaThresholdPct{};
+        float magickaReducePct{};
+        float magickaSmoothWidthPct{};
+        bool dwEnabled{};
+        bool dwSlopeFeatureEnabled{};
+        float dwStartDeg{};
+        float dwFullDeg{};
+        float dwBuildUpPerSec{};
+        float dwDryPerSec{};
+        LocationAffects locationAffects{};
+        LocationMode locationMode{};
+        bool weatherEnabled{};
+        WeatherAffects weatherAffects{};
+        WeatherMode weatherMode{};
+        bool weatherIgnoreInterior{};
+        std::shared_ptr<const FormRules> rules;  // shared between snapshots until the lists change
+
+        std::uint64_t epoch = 0;  // bumped by every publish that changed something
+        bool operator==(const Snapshot&) const = default;
+    };
+
+    // Every write to the statics (menu, JSON load) and every capture of them runs under this lock: the menu holds it
+    // for a whole render pass, the loader for the whole apply. Recursive, so a holder can Publish().
+    static std::recursive_mutex& WriteMutex();
+    [[nodiscard]] static std::unique_lock<std::recursive_mutex> LockWrites() {
+        return std::unique_lock<std::recursive_mutex>(WriteMutex());
+    }
+
+    // Never null, the first call captures the statics as they are
+    static std::shared_ptr<const Snapshot> Current();
+    // Publishes the statics if they differ from the current snapshot, true if it did. Cheap when nothing changed.
+    static bool Publish();
+
     static bool SaveToJson(const std::filesystem::path& file);
     static bool LoadFromJson(const std::filesystem::path& file);
+    // Parses the file only if its size, mtime or content hash differ from the last load or save. An unchanged
+    // file is applied again from the kept document, so the statics always end up as the file says.
+    enum class LoadResult { Loaded, Unchanged, Failed };
+    static LoadResult LoadFromJsonIfChanged(const std::filesystem::path& file);
+    // Applies the document of the last load or save to the statics and publishes
+    static void ApplyLastJson();
 
     static std::filesystem::path DefaultPath();
 };
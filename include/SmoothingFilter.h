@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Settings.h"
+
+// Smoothing filter policies. Each policy holds its precomputed coefficients and a Step() without mode branches,
+// SmoothingFilter picks one from the settings and only rebuilds it when those change.
+// A new mode = a new policy struct, a Kind and a case in Visit() (plus a vector step in BatchMath.cpp).
+namespace MovementMath {
+    struct PassThroughPolicy {
+        float Step(float, float target, float) const { return target; }
+    };
+
+    // prev + (target - prev) * (1 - exp(-dt / tau))
+    struct ExpoPolicy {
+        float invTau = 0.0f;
+        bool instant = false;  // tau ~ 0, jump to the target
+
+        static ExpoPolicy FromHalfLifeMs(float halfLifeMs) {
+            const float tau = std::max(halfLifeMs / 1000.0f / 0.69314718056f, 1e-4f);
+            return {1.0f / tau, false};
+        }
+        static ExpoPolicy FromTauSec(float tauSec) { return {1.0f / std::max(1e-4f, tauSec), tauSec <= 1e-6f}; }
+
+        float Step(float prev, float target, float dt) const {
+            if (instant) return target;
+            const float a = std::clamp(1.0f - std::exp(-dt * invTau), 0.0f, 1.0f);
+            return prev + (target - prev) * a;
+        }
+    };
+
+    // At most maxPerSec * dt per step
+    struct RatePolicy {
+        float maxPerSec = 0.0f;
+        bool unlimited = false;
+
+        static RatePolicy Limit(float maxPerSec) { return {std::max(0.0f, maxPerSec), false}; }  // <= 0 freezes
+        static RatePolicy Towards(float ratePerSec) { return {ratePerSec, ratePerSec <= 0.0f}; }  // <= 0 is off
+
+        float Step(float prev, float target, float dt) const {
+            if (unlimited) return target;
+            const float maxStep = maxPerSec * dt;
+            return prev + std::clamp(target - prev, -maxStep, maxStep);
+        }
+    };
+
+    struct ExpoThenRatePolicy {
+        ExpoPolicy expo;
+        RatePolicy rate;
+
+        float Step(float prev, float target, float dt) const {
+            return rate.Step(prev, expo.Step(prev, target, dt), dt);
+        }
+    };
+
+    class SmoothingFilter {
+    public:
+        enum class Kind : std::uint8_t { PassThrough, Expo, Rate, ExpoThenRate };
+
+        // Movement delta smoothing (smoothingMode / smoothingHalfLifeMs / smoothingMaxChangePerSecond)
+        static SmoothingFilter Movement(Settings::SmoothingMode mode, float halfLifeMs, float maxPerSec) {
+            SmoothingFilter f;
+            f.expo_ = ExpoPolicy::FromHalfLifeMs(halfLifeMs);
+            f.rate_ = RatePolicy::Limit(maxPerSec);
+            f.kind_ = FromMode(mode);
+            return f;
+        }
+
+        // Sprint animation rate (sprintAnim* settings), pass-through without its own smoothing
+        static SmoothingFilter SprintAnim(bool ownSmoothing, Settings::SmoothingMode mode, float tauSec,
+                                          float ratePerSec) {
+            SmoothingFilter f;
+            f.expo_ = ExpoPolicy::FromTauSec(tauSec);
+            f.rate_ = RatePolicy::Towards(ratePerSec);
+            f.kind_ = ownSmoothing ? FromMode(mode) : Kind::PassThrough;
+            return f;
+        }
+
+        // Rebuild from the snapshot if any of its values changed since the last sync, true if it did
+        bool SyncMovement(const Settings::Snapshot& c) {
+            const Source src{static_cast<int>(c.smoothingMode), c.smoothingHalfLifeMs, c.smoothingMaxChangePerSecond,
+                             true};
+            if (built_ && src == src_) return false;
+            *this = Movement(c.smoothingMode, src.a, src.b);
+            Remember(src);
+            return true;
+        }
+
+        bool SyncSprintAnim(const Settings::Snapshot& c) {
+            const Source src{c.sprintAnimSmoothingMode, c.sprintAnimTau, c.sprintAnimRatePerSec,
+                             c.sprintAnimOwnSmoothing};
+            if (built_ && src == src_) return false;
+            *this = SprintAnim(src.own, static_cast<Settings::SmoothingMode>(src.mode), src.a, src.b);
+            Remember(src);
+            return true;
+        }
+
+        Kind kind() const { return kind_; }
+
+        // Calls f with the concrete policy, the mode switch happens here once instead of per actor
+        template <class F>
+        decltype(auto) Visit(F&& f) const {
+            switch (kind_) {
+                case Kind::Expo:
+                    return f(expo_);
+                case Kind::Rate:
+                    return f(rate_);
+                case Kind::ExpoThenRate:
+                    return f(ExpoThenRatePolicy{expo_, rate_});
+                default:
+                    return f(PassThroughPolicy{});
+            }
+        }
+
+        // Single value, for callers with one actor
+        float Step(float prev, float target, float dt) const {
+            return Visit([&](const auto& p) { return p.Step(prev, target, dt); });
+        }
+
+    private:
+        struct Source {
+            int mode = 0;
+            float a = 0.0f, b = 0.0f;
+            bool own = true;
+            bool operator==(const Source&) const = default;
+        };
+
+        static Kind FromMode(Settings::SmoothingMode mode) {
+            switch (mode) {
+                case Settings::SmoothingMode::RateLimit:
+                    return Kind::Rate;
+                case Settings::SmoothingMode::ExpoThenRate:
+                    return Kind::ExpoThenRate;
+                default:
+                    return Kind::Expo;
+            }
+        }
+
+        void Remember(const Source& src) {
+            src_ = src;
+            built_ = true;
+        }
+
+        Kind kind_ = Kind::PassThrough;
+        ExpoPolicy expo_{};
+        RatePolicy rate_{};
+        Source src_{};
+        bool built_ = false;
+    };
+}
@@ -1,20 +1,26 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include "ActorAccess.h"
+#include "FormRuleIndex.h"
+#include "GraphVarCache.h"
+#include "HeartbeatScheduler.h"
+#include "InputActionMap.h"
 #include "Settings.h"
+#include "SmoothingFilter.h"
+#include "SpeedCore.h"
 
-struct PathSample {
-    float x, y, z;
-    float sxy;     // Cumulative distance in XY plane
-    uint64_t tMs;  // Timestamp in milliseconds
-};
-
+// SKSE side of the controller: event sinks, heartbeat, save/load and the ActorAccess adapter for SpeedCore.
+// The movement pipeline itself lives in SpeedCore.
 class SpeedController : public RE::BSTEventSink<RE::TESCombatEvent>,
                         public RE::BSTEventSink<RE::TESLoadGameEvent>,
                         public RE::BSTEventSink<RE::BSAnimationGraphEvent>,
                         public RE::BSTEventSink<RE::InputEvent*>,
-                        public RE::BSTEventSink<RE::TESEquipEvent> {
+                        public RE::BSTEventSink<RE::TESEquipEvent>,
+                        public ActorAccess {
 public:
     static SpeedController* GetSingleton();
 
@@ -30,6 +36,7 @@ public:
     void OnPreLoadGame();
     void DoPostLoadCleanup();
 
+    // Menu entry points (UI thread): publish the edited statics, then Apply + refresh as a game thread task
     void RefreshNow();
     void UpdateBindingsFromSettings();
 
@@ -39,87 +46,61 @@ public:
     float GetCurrentDelta() const;
     void SetCurrentDelta(float d);
 
-    float GetDiagDelta() const { return diagDelta_; }
-    void SetDiagDelta(float d) { diagDelta_ = d; }
+    float GetDiagDelta() const { return core_.Actors().diagDelta[ActorStateTable::kPlayerSlot]; }
+    void SetDiagDelta(float d) { core_.Actors().diagDelta[ActorStateTable::kPlayerSlot] = d; }
+
+    float GetSlopeDelta() const { return core_.Actors().slopeDelta[ActorStateTable::kPlayerSlot]; }
 
-    float GetSlopeDelta() const { return slopeDeltaPlayer_; }
+    const SpeedCore& Core() const { return core_; }
 
     void SetSnapshot(bool jogging, float curDelta, float diag, float baseSM, float slope) {
-        joggingMode_ = jogging;
-        currentDelta = curDelta;
-        diagDelta_ = diag;
+        constexpr auto p = ActorStateTable::kPlayerSlot;
+        auto& t = core_.Actors();
+        core_.joggingMode = jogging;
+        t.moveDelta[p] = curDelta;
+        t.diagDelta[p] = diag;
         savedBaselineSM_ = baseSM;
-        slopeDeltaPlayer_ = slope;
+        t.slopeDelta[p] = slope;
         snapshotLoaded_.store(true, std::memory_order_relaxed);
     }
 
-    std::deque<PathSample> pathPlayer_;
-    std::unordered_map<std::uint32_t, std::deque<PathSample>> pathNPC_;
-
-    std::deque<PathSample>& PathBuf(RE::Actor* a);
-    void ClearPathFor(RE::Actor* a);
-    void PushPathSample(RE::Actor* a, const RE::NiPoint3& pos, uint64_t nowMs);
-    bool ComputePathSlopeDeg(RE::Actor* a, float lookbackUnits, float maxAgeSec, float& outDeg);
-    void ClearScaleDeltaFor(RE::Actor* a);
-    bool UpdateScaleCompDelta(RE::Actor* a, float predictedNoScaleFinal);
-    float& ScaleDeltaSlot(RE::Actor* a);
-
-    float diagResidualPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> diagResidualNPC_;
-
-    float slopeResidualPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> slopeResidualNPC_;
-
-    float scaleResidualPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> scaleResidualNPC_;
-    float scaleDeltaPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> scaleDeltaNPC_;
-
-    inline float& DiagResidualSlot(RE::Actor* a) {
-        auto* pc = RE::PlayerCharacter::GetSingleton();
-        if (a == pc) return diagResidualPlayer_;
-        return diagResidualNPC_[a->GetFormID()];
-    }
-    inline float& SlopeResidualSlot(RE::Actor* a) {
-        auto* pc = RE::PlayerCharacter::GetSingleton();
-        if (a == pc) return slopeResidualPlayer_;
-        return slopeResidualNPC_[a->GetFormID()];
-    }
-    inline float& ScaleResidualSlot(RE::Actor* a) {
-        auto* pc = RE::PlayerCharacter::GetSingleton();
-        if (a == pc) return scaleResidualPlayer_;
-        return scaleResidualNPC_[a->GetFormID()];
+    std::uint64_t NowMs() const override {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
     }
 
 private:
-    enum class MoveCase : std::uint8_t { Combat, Drawn, Sneak, Default };
-    float SmoothExpo(float prev, float target, float dtSec) const {
-        // alpha = 1 - exp(-dt / tau); tau = hl/ln2
-        const float hlSec = Settings::smoothingHalfLifeMs.load() / 1000.0f;
-        const float tau = std::max(hlSec / 0.69314718056f, 1e-4f);
-        const float a = 1.0f - std::exp(-dtSec / tau);
-        return prev + (target - prev) * std::clamp(a, 0.0f, 1.0f);
+    // ActorAccess
+    bool IsSprinting(ActorRef a) const override { return IsSprintingLatched(AsActor(a)); }
+    bool IsSneaking(ActorRef a) const override { return AsActor(a)->IsSneaking(); }
+    bool IsInCombat(ActorRef a) const override { return AsActor(a)->IsInCombat(); }
+    bool IsWeaponDrawn(ActorRef a) const override { return IsWeaponDrawnByState(AsActor(a)); }
+    bool IsInBeastForm(ActorRef a) const override { return IsInBeastForm(AsActor(a)); }
+    const void* GetRace(ActorRef a) const override { return AsActor(a)->GetRace(); }
+    bool GetMoveAxes(ActorRef a, float& outX, float& outY) const override {
+        return TryGetMoveAxesFromGraph(AsActor(a), outX, outY);
     }
-    float SmoothRate(float prev, float target, float dtSec) const {
-        const float maxPerSec = Settings::smoothingMaxChangePerSecond.load();
-        const float maxStep = std::max(0.0f, maxPerSec) * dtSec;
-        float d = target - prev;
-        if (d > maxStep) d = maxStep;
-        if (d < -maxStep) d = -maxStep;
-        return prev + d;
-    }
-    float SmoothCombined(float prev, float target, float dtSec) const {
-        using SM = Settings::SmoothingMode;
-        switch (Settings::smoothingMode) {
-            case SM::Exponential:
-                return SmoothExpo(prev, target, dtSec);
-            case SM::RateLimit:
-                return SmoothRate(prev, target, dtSec);
-            case SM::ExpoThenRate:
-                return SmoothRate(prev, SmoothExpo(prev, target, dtSec), dtSec);
-        }
-        return target;
+    Vec3 GetPosition(ActorRef a) const override;
+    float GetScale(ActorRef a) const override;
+    float GetEquippedWeight(ActorRef a) const override { return ComputeEquippedWeight(AsActor(a)); }
+    ArmorWeight GetArmorWeight(ActorRef a) const override { return ComputeArmorWeight(AsActor(a)); }
+    ActorPlace GetPlace(ActorRef a) const override;
+    std::optional<float> GetLocationModifier(const ActorPlace& p) const override;
+    std::optional<float> GetWeatherModifier(const ActorPlace& p) const override;
+    float GetActorValue(ActorRef a, ActorStat av) const override;
+    float GetPermanentActorValue(ActorRef a, ActorStat av) const override;
+    void ModActorValue(ActorRef a, ActorStat av, float delta) override;
+    bool ForceSpeedRefresh(ActorRef a) override { return ForceSpeedRefresh(AsActor(a)); }
+    void RequestRefresh(ActorRef) override {
+        pendingRefresh_.store(true, std::memory_order_relaxed);
+        WakeHeartbeat();
     }
+    void PublishSweat(ActorRef a, float intensity) override;
+    void ClearSweat(ActorRef a) override;
+
+    static ActorRef Ref(RE::Actor* a) { return ActorRef{a, a ? a->GetFormID() : 0}; }
+    static RE::Actor* AsActor(ActorRef a) { return static_cast<RE::Actor*>(a.handle); }
+
     std::atomic<bool> pendingRefresh_{false};
     std::atomic<bool> refreshGuard_{false};
     std::atomic<uint64_t> lastRefreshMs_{0};
@@ -132,123 +113,86 @@ private:
     static constexpr float kRefreshEps = 0.10f;
 
     float sprintAnimRate_ = 1.0f;
+    MovementMath::SmoothingFilter sprintFilter_;
 
-    float smVelPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> smVelNPC_;
-
-    float wantFilteredPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> wantFilteredNPC_;
-
-    uint64_t lastApplyPlayerMs_ = 0;
-    std::unordered_map<std::uint32_t, uint64_t> lastApplyNPCMs_;
-
-    uint64_t lastSlopePlayerMs_ = 0;
-    std::unordered_map<uint32_t, uint64_t> lastSlopeNPCMs_;
+    // Movement pipeline + per-actor state (slot 0 = player)
+    SpeedCore core_{*this};
 
-    bool prevPlayerSprinting_ = false;
-    bool prevPlayerSneak_ = false;
-    bool prevPlayerDrawn_ = false;
+    // Location/weather rules and beast races resolved to FormIDs, rebuilt on settings change
+    FormRuleIndex rules_;
 
-    std::unordered_map<std::uint32_t, bool> prevNPCSprinting_;
-    std::unordered_map<std::uint32_t, bool> prevNPCSneak_;
-    std::unordered_map<std::uint32_t, bool> prevNPCDrawn_;
+    // Graph variable names that exist per behavior graph, filled on first use
+    mutable GraphVarCache graphVars_;
 
-    // Movement speed (To fix the diagonal speed issue of skyrim)
-    float moveX_ = 0.0f;  // -1 ... +1  (left/right)
-    float moveY_ = 0.0f;  // -1 ... +1  (forward/backward)
-    float diagDelta_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> diagDeltaNPC_;
-
-    // Deltas: Player vs. NPCs
-    float currentDelta = 0.0f;
-    float attackDelta_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> currentDeltaNPC_;
-    std::unordered_map<std::uint32_t, float> attackDeltaNPC_;
     bool prevAffectNPCs_ = false;
+    std::vector<ActorRef> npcBuf_;  // the span of Apply's Tick (empty if it did not get there), for the flush after it
 
-    bool initTried_ = false;
     std::atomic<bool> run_ = false;
     std::atomic<bool> loading_{false};
     std::thread th_;
 
-    bool joggingMode_ = false;    // false=OutOfCombat normal, true=Jogging
-    uint32_t toggleKeyCode_ = 0;
-    std::string toggleUserEvent_;
+    // Heartbeat cadence, written by the task on the game thread, read by the heartbeat thread
+    HeartbeatScheduler scheduler_;
+    std::atomic<std::uint32_t> nextBeatMs_{HeartbeatScheduler::kActiveMs};
+    std::mutex wakeMx_;
+    std::condition_variable wakeCv_;
+    bool wake_ = false;
+
+    // Input bindings, rebuilt from the Settings statics by PublishActionMap (UI or game thread) and
+    // read by the input sink. The held chord keys belong to the sink and reset when the map changes.
+    std::atomic<std::shared_ptr<const InputActionMap>> actionMap_{std::make_shared<const InputActionMap>()};
+    InputActionMap::KeyState heldKeys_ = 0;
+    const InputActionMap* heldKeysMap_ = nullptr;
+
+    // Raw player axes from the input sink, shaped into core_.moveX/moveY by FlushInput (both on the game thread)
+    float rawMoveX_ = 0.0f;
+    float rawMoveY_ = 0.0f;
+    bool inputDirty_ = false;
 
     std::atomic<uint64_t> lastSprintMs_{0};
     static constexpr uint64_t kSprintLatchMs = 150;
-    std::string sprintUserEvent_ = "Sprint";
-
-    std::atomic<uint64_t> lastRefreshPlayerMs_{0};
-    std::unordered_map<RE::FormID, uint64_t> lastRefreshNPCMs_;
 
     std::chrono::steady_clock::time_point lastToggle_{};
     std::chrono::milliseconds toggleCooldown_{150};
 
-    float slopeDeltaPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> slopeDeltaNPC_;
-
-    RE::NiPoint3 lastPosPlayer_{};
-    std::unordered_map<std::uint32_t, RE::NiPoint3> lastPosNPC_;
-
-    // Ground delta-Slots (analog to slope/diag)
-    float groundDeltaPlayer_ = 0.0f;
-    std::unordered_map<std::uint32_t, float> groundDeltaNPC_;
-
-    void ClampSpeedFloorTracked(RE::Actor* a);
-    void RevertMovementDeltasFor(RE::Actor* a, bool clearSlope = true);
-    float& SlopeDeltaSlot(RE::Actor* a);
-    void ClearSlopeDeltaFor(RE::Actor* a);
-    void ClearNPCState(std::uint32_t id);
-    bool UpdateSlopePenalty(RE::Actor* a, float dt);
-    void UpdateSlopeTickNPCsOnly();
-    void UpdateSlopeTickOnly();
-
-    void UpdateSprintAnimRate(RE::Actor* a);
-
-    void LoadToggleBindingFromJson();
+    // DynamicWetness environment (in water / wet weather) as of the last query. Asked again when the cell or the
+    // weather changes, and after kWetEnvMaxAgeMs for wading in and out of water.
+    struct WetEnvCache {
+        const void* cell = nullptr;
+        const void* weather = nullptr;
+        uint64_t queriedMs = 0;
+        bool wet = false;
+        bool valid = false;
+    } wetEnv_;
+    static constexpr uint64_t kWetEnvMaxAgeMs = 1000;
+    bool IsWorldWet(RE::Actor* a);
+
+    // Returns true while the anim rate is still converging
+    bool UpdateSprintAnimRate(RE::Actor* a);
+
+    // SpeedController.json through Settings::LoadFromJsonIfChanged, logs the outcome and the time it took
+    void ReloadSettings();
+    // Once per heartbeat (and before a toggle): latest sink axes -> deadzone / step -> core_.moveX/moveY
+    void FlushInput();
+    void PublishActionMap();
 
     void StartHeartbeat();
     void StopHeartbeat();
-    void TryInitDrawnFromGraph();
-
-    MoveCase ComputeCase(const RE::Actor* pc) const;
-    float CaseToDelta(const RE::Actor* pc) const;
+    // Back to the active cadence right away, called from the event sinks
+    void WakeHeartbeat();
 
     void Apply();
-    void ApplyFor(RE::Actor* a);
 
-    void UpdateAttackSpeed(RE::Actor* actor);
     float ComputeEquippedWeight(const RE::Actor* a) const;
-    float GetPlayerScaleSafe(const RE::Actor* a) const;
+    ArmorWeight ComputeArmorWeight(const RE::Actor* a) const;
 
     static std::uint32_t GetID(const RE::Actor* a) { return a ? a->GetFormID() : 0; }
-    float& AttackDeltaSlot(RE::Actor* a);
-    float& CurrentDeltaSlot(RE::Actor* a);
-
-    void ForEachTargetActor(const std::function<void(RE::Actor*)>& fn);
-    void RevertDeltasFor(RE::Actor* a);
-    void RevertAllNPCDeltas(); 
 
-    static bool IsInBeastForm(const RE::Actor* a);
-    static void ModSpeedMult(RE::Actor* actor, float delta);
+    bool IsInBeastForm(const RE::Actor* a) const;
     bool ForceSpeedRefresh(RE::Actor* actor);
     static bool IsWeaponDrawnByState(const RE::Actor* a);
-    static bool IsSprintingByGraph(const RE::Actor* a);
+    bool IsSprintingByGraph(const RE::Actor* a) const;
     bool IsSprintingLatched(const RE::Actor* a) const;
 
-    float& DiagDeltaSlot(RE::Actor* a);
-    void ClearDiagDeltaFor(RE::Actor* a);
-
     bool TryGetMoveAxesFromGraph(const RE::Actor* a, float& outX, float& outY) const;
-
-    bool UpdateDiagonalPenalty(RE::Actor* a, float inX, float inY);
-    bool UpdateDiagonalPenalty(RE::Actor* a);
-
-    float ComputeArmorWeight(const RE::Actor* a) const;
-
-    static inline uint64_t NowMs() {
-        using namespace std::chrono;
-        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
-    }
 };
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "ActorAccess.h"
+#include "ActorStateTable.h"
+#include "Settings.h"
+#include "SmoothingFilter.h"
+
+// Engine-independent movement pipeline: movement case, location/weather/armor/vitals/scale contributions,
+// smoothing, diagonal fix, slope penalty, scale compensation, speed floor and attack speed.
+// All engine access goes through ActorAccess, so the same code runs in game and in the simulation harness.
+//
+// A tick runs in two stages: Gather() reads everything an actor needs from the engine into one ActorInputs,
+// then the update stages work on that snapshot only. The ActorRef overloads are for event handlers outside
+// the tick, they gather on their own.
+class SpeedCore {
+public:
+    enum class MoveCase : std::uint8_t { Combat, Drawn, Sneak, Default };
+    enum class LodTier : std::uint8_t { Near, Mid, Far, Out };
+    static_assert(static_cast<std::uint8_t>(LodTier::Out) == ActorStateTable::kLodUnclassified);
+
+    explicit SpeedCore(ActorAccess& access) : access_(access) { SyncSettings(); }
+
+    // Takes the current Settings snapshot. Everything in the core (ticks and event updates alike) works on the
+    // snapshot of the last call, so this runs once at the start of every heartbeat.
+    void SyncSettings();
+    const Settings::Snapshot& Config() const { return *settings_; }
+
+    void SetPlayer(ActorRef p) { player_ = p; }
+    ActorRef Player() const { return player_; }
+
+    ActorStateTable& Actors() { return actors_; }
+    const ActorStateTable& Actors() const { return actors_; }
+    ActorStateTable::Slot SlotOf(ActorRef a) { return actors_.Acquire(a.formID); }
+
+    // One heartbeat pass over the player and the given NPCs
+    void Tick(std::span<const ActorRef> npcs);
+    void ApplyFor(ActorRef a);
+    void UpdateSlopeTickNPCsOnly(std::span<const ActorRef> npcs);
+    void RevertAllNPCDeltas(std::span<const ActorRef> npcs);
+    // Same as RevertAllNPCDeltas, but spread over the next ticks within npcBudgetUs. Cancelled if NPC scaling
+    // gets enabled again before it is done.
+    void BeginNPCRevert() {
+        revertPending_ = true;
+        revertCursor_ = 0;
+    }
+    bool NPCRevertPending() const { return revertPending_; }
+
+    // Gather stage. Returns false if the actor is skipped this tick (beast form / out of range),
+    // in that case only nowMs, pos, beast and inRange are filled.
+    bool Gather(ActorRef a, ActorInputs& in);
+
+    MoveCase ComputeCase(const ActorInputs& in) const;
+    // Uncached movement target from a full snapshot (in.armorCached must be false). The tick uses MovementTarget.
+    float CaseToDelta(const ActorInputs& in) const;
+
+    // Movement case contributions, cached per actor. Events mark what they invalidate, everything without an event
+    // (state flags, place, vitals, scale) is compared against the cached inputs every tick.
+    static constexpr std::uint8_t kDirtyState = 1 << 0;  // combat / sneak / drawn / sprint, location, weather
+    static constexpr std::uint8_t kDirtyArmor = 1 << 1;  // equipment: new armor / weapon weight read on next use
+    static constexpr std::uint8_t kDirtyVitals = 1 << 2;
+    static constexpr std::uint8_t kDirtyScale = 1 << 3;
+    static constexpr std::uint8_t kDirtyPlace = 1 << 4;  // forces a new location rule lookup
+    static constexpr std::uint8_t kDirtyAll = 0x1F;
+    // No-op for actors without a slot, their first update builds everything
+    void MarkDirty(ActorRef a, std::uint8_t bits) {
+        const auto s = actors_.Find(a.formID);
+        if (s == ActorStateTable::kNoSlot) return;
+        actors_.caseCache[s].dirty |= bits;
+        if (bits & kDirtyArmor) {
+            actors_.armorCache[s].valid = false;
+            actors_.attackCache[s].weaponValid = false;
+        }
+    }
+
+    // Equip event: nothing is read here, the worn state can still lag behind the event. The actor's next gather
+    // marks kDirtyArmor and reads once, and an NPC's attack speed is updated after that apply. No-op for actors
+    // without a slot, like MarkDirty.
+    void MarkEquipChanged(ActorRef a) {
+        const auto s = actors_.Find(a.formID);
+        if (s != ActorStateTable::kNoSlot) actors_.armorCache[s].equipPending = true;
+    }
+
+    bool UpdateDiagonalPenalty(ActorRef a);
+    // Cheap to call every tick: probes drawn state, scale and the settings epoch and only touches
+    // kWeaponSpeedMult when the target moved. Weapon and armor weight are re-read after MarkDirty(kDirtyArmor).
+    void UpdateAttackSpeed(ActorRef a);
+
+    void ClearDiagDeltaFor(ActorRef a, ActorInputs* in = nullptr);
+    bool ClearSlopeDeltaFor(ActorRef a, ActorInputs* in = nullptr);  // true if a delta was reverted
+    void ClearScaleDeltaFor(ActorRef a, ActorInputs* in = nullptr);
+    void RevertDeltasFor(ActorRef a, ActorInputs* in = nullptr);
+    void RevertMovementDeltasFor(ActorRef a, bool clearSlope = true, ActorInputs* in = nullptr);
+    void ClearNPCState(std::uint32_t id) { actors_.Release(id); }
+
+    bool IsWithinNPCProcRadius(ActorRef a) const;
+
+    // Flips joggingMode and moves the player's movement delta over to the new mode
+    void ToggleJogging();
+
+    // Engine refreshes (ActorAccess::ForceSpeedRefresh) are collected instead of issued: one queue entry per actor
+    // however many stages asked, run by FlushRefreshes. Call that once after Tick and at the end of any event
+    // handler that reverts or toggles. An actor refreshed less than its minimum interval ago is skipped and owed
+    // one, queued again by a later flush: the player by any, an NPC only by one that gets the span just handed to
+    // Tick (event handlers pass none, their handles may be gone). Actors released after they were queued are
+    // refreshed right away, that is the one that restores their vanilla speed.
+    void QueueRefresh(ActorRef a);
+    void FlushRefreshes(std::span<const ActorRef> npcs = {});
+
+    struct RefreshStats {
+        std::uint64_t requested = 0;
+        std::uint64_t coalesced = 0;  // actor was already queued
+        std::uint64_t executed = 0;
+        std::uint64_t throttled = 0;  // inside the minimum interval
+    };
+    const RefreshStats& Refreshes() const { return refreshStats_; }
+
+    // SpeedMult write-back counters: component writes issued by the update stages vs ModActorValue calls that
+    // actually reached the engine after batching
+    struct WriteStats {
+        std::uint64_t componentWrites = 0;
+        std::uint64_t engineWrites = 0;
+        std::uint64_t cancelledCommits = 0;  // batches whose components summed to ~0, no write at all
+    };
+    const WriteStats& Stats() const { return stats_; }
+    void ResetStats() {
+        stats_ = {};
+        caseStats_ = {};
+        refreshStats_ = {};
+    }
+
+    // Movement case cache counters: targets computed vs contributions actually rebuilt, and the engine lookups
+    // the gather still did
+    struct CaseCacheStats {
+        std::uint64_t targets = 0;
+        std::uint64_t rebuilt[4] = {};  // state, armor, vitals, scale
+        std::uint64_t armorReads = 0;
+        std::uint64_t locationLookups = 0;
+        std::uint64_t beastChecks = 0;  // IsInBeastForm calls, one per race change
+    };
+    const CaseCacheStats& CaseStats() const { return caseStats_; }
+
+    // NPCs per LOD tier in the last full tick, and how many of them actually got an update
+    struct LodCounts {
+        std::uint32_t tier[4] = {};
+        std::uint32_t updated = 0;
+    };
+    const LodCounts& LastTickLod() const { return lastLod_; }
+
+    // Round-robin NPC pass
+    struct SliceStats {
+        std::uint32_t processed = 0;     // NPCs visited in the last full tick
+        std::uint32_t total = 0;         // NPCs handed in
+        std::uint64_t budgetStops = 0;   // ticks (full or slope-only) that stopped early on the budget
+        std::uint64_t roundTripMs = 0;   // time the cursor took for the last full lap (= worst staleness)
+    };
+    const SliceStats& Slicing() const { return slice_; }
+
+    // The getters above are for the game thread. Other threads (the Diagnostics page) read this copy instead, taken
+    // once per heartbeat by PublishStats, so all of it is from the same tick. Null before the first publish.
+    struct StatsView {
+        WriteStats writes;
+        LodCounts lod;
+        SliceStats slice;
+        RefreshStats refreshes;
+    };
+    void PublishStats() {
+        statsView_.store(std::make_shared<const StatsView>(StatsView{stats_, lastLod_, slice_, refreshStats_}),
+                         std::memory_order_release);
+    }
+    std::shared_ptr<const StatsView> PublishedStats() const { return statsView_.load(std::memory_order_acquire); }
+
+    // Tier for an actor at pos, staying in prev until it is npcLodHysteresis past the edge
+    LodTier ClassifyLod(const Vec3& pos, LodTier prev) const;
+
+    // True if anything was written, moved or flipped since the last call. Drives the heartbeat cadence.
+    bool ConsumeActivity() {
+        const bool b = active_;
+        active_ = false;
+        return b;
+    }
+
+    bool joggingMode = false;  // false=OutOfCombat normal, true=Jogging
+
+    // Player movement input (To fix the diagonal speed issue of skyrim)
+    float moveX = 0.0f;  // -1 ... +1  (left/right)
+    float moveY = 0.0f;  // -1 ... +1  (forward/backward)
+
+private:
+    void ApplyFor(ActorRef a, ActorInputs& in);
+    bool Gather(ActorRef a, ActorInputs& in, bool checkRange);
+    // GetArmorWeight through the slot's ArmorCache, shared by the movement case and attack speed
+    ArmorWeight ArmorOf(ActorRef a);
+    // IsInBeastForm through the slot's RaceCache
+    bool BeastForm(ActorRef a);
+    // LOD-aware gather for one NPC, false if the actor has nothing to do this tick
+    bool GatherNPC(ActorRef a, ActorInputs& in);
+    // One NPC of UpdateSlopeTickNPCsOnly
+    void SlopeTickNPC(ActorRef a);
+    void RevertNPC(ActorRef a);
+    void StepNPCRevert(std::span<const ActorRef> npcs);
+
+    using Clock = std::chrono::steady_clock;
+    static bool OverBudget(Clock::time_point start, int us) {
+        return us > 0 && (Clock::now() - start) >= std::chrono::microseconds(us);
+    }
+    static constexpr std::size_t kSliceChunk = 16;  // NPCs per gather/apply round between budget checks
+    // Batch kernel stage between gather and apply: movement target, smoothing, diagonal factor and slope angle
+    // for every due NPC of the chunk, written to ActorInputs::pre
+    void PrecomputeChunk(std::span<const ActorRef> npcs, std::size_t first, std::size_t chunk);
+    float StepDt(ActorStateTable::Slot s, std::uint64_t nowMs) const;
+
+    // Every setting the movement case reads, snapshotted once per tick. Any change rebuilds all cached contributions.
+    struct CaseSettings {
+        struct Vital {
+            bool on = false;
+            float threshold = 0.0f, reduce = 0.0f, width = 0.0f;
+            bool operator==(const Vital&) const = default;
+        };
+
+        float reduceOutOfCombat = 0.0f, reduceJogging = 0.0f, reduceDrawn = 0.0f, reduceSneak = 0.0f;
+        float increaseSprinting = 0.0f;
+        bool noReductionInCombat = false, sprintAffectsCombat = false;
+        Settings::LocationMode locationMode{};
+        Settings::LocationAffects locationAffects{};
+        bool weather = false;
+        Settings::WeatherAffects weatherAffects{};
+        Settings::WeatherMode weatherMode{};
+        bool armor = false, useMaxArmorWeight = false;
+        float armorSlope = 0.0f, armorPivot = 0.0f, armorMin = 0.0f, armorMax = 0.0f;
+        Vital health, stamina, magicka;
+        bool scaleAdditive = false, scaleOnlyBelowOne = false;
+        float scalePerUnit = 0.0f;
+        std::uint32_t formRules = 0;  // location / weather rule revision
+
+        static CaseSettings Read(const Settings::Snapshot& c);
+        bool operator==(const CaseSettings&) const = default;
+    };
+    // New epoch if the CaseSettings of the snapshot differ from the cached ones
+    void SyncCaseSettings();
+    // Weather modifiers for the tick, after the caller had the chance to update its rules
+    void ResolveWeather();
+    bool CaseCached(ActorStateTable::Slot s, std::uint8_t bit) const {
+        if (s == ActorStateTable::kNoSlot) return false;
+        const auto& c = actors_.caseCache[s];
+        return c.epoch == caseEpoch_ && !(c.dirty & bit);
+    }
+    // CaseToDelta through the slot's cache, only dirty contributions are recomputed
+    float MovementTarget(ActorStateTable::Slot s, const ActorInputs& in);
+    static MoveCase CaseOf(const CaseSettings& k, const ActorInputs& in);
+    float StatePart(const CaseSettings& k, const ActorInputs& in) const;
+    static float ArmorPart(const CaseSettings& k, const ArmorWeight& armor);
+    static float VitalsPart(const CaseSettings& k, const ActorInputs& in);
+    static float ScalePart(const CaseSettings& k, float scale);
+    std::uint8_t StateKey(const ActorInputs& in) const;
+    bool UpdateDiagonalPenalty(ActorRef a, ActorInputs& in, float diagFactor);
+    bool UpdateSlopePenalty(ActorRef a, ActorInputs& in, float dt);
+    // Hands the sweat intensity to Dynamic Wetness only when it moved by kSweatStep or the last mask is about to
+    // run out, and clears once when it reaches 0. ClearSweat only calls out while a mask is outstanding.
+    static constexpr float kSweatStep = 0.01f;
+    static constexpr std::uint64_t kSweatResendMs = 1000;  // masks are sent with a 1.75 s hold
+    void PublishSweat(ActorRef a, ActorStateTable::Slot s, std::uint64_t nowMs);
+    void ClearSweat(ActorRef a, ActorStateTable::Slot s);
+    bool UpdateScaleCompDelta(ActorRef a, ActorInputs& in, float predictedNoScaleFinal);
+    void ClampSpeedFloorTracked(ActorRef a, ActorInputs& in);
+    bool InRadius(const Vec3& pos) const;
+
+    // Path history ring sizing: slopeMaxHistorySec / interval samples, capped
+    static constexpr std::uint64_t kPathSampleMinIntervalMs = 16;
+    static constexpr std::uint64_t kPathRingMaxCapacity = 1024;
+    void PushPathSample(ActorStateTable::Slot s, const Vec3& pos, std::uint64_t nowMs);
+    void ModSpeedMult(ActorRef a, ActorInputs* in, float delta) {
+        ++stats_.componentWrites;
+        if (std::fabs(delta) > kActivityWriteEps) active_ = true;
+        if (in) {
+            in->speedMult += delta;
+            if (in->batching) {
+                in->pendingSpeedMult += delta;
+                ++in->pendingWrites;
+                return;
+            }
+        }
+        access_.ModActorValue(a, ActorStat::SpeedMult, delta);
+        ++stats_.engineWrites;
+    }
+    // Deferred to the commit while batching, so the engine recomputes from the final value
+    void Refresh(ActorRef a, ActorInputs* in) {
+        if (in && in->batching)
+            in->refreshWanted = true;
+        else
+            QueueRefresh(a);
+    }
+    static void BeginBatch(ActorInputs& in) {
+        in.batching = true;
+        in.refreshWanted = false;
+        in.pendingWrites = 0;
+        in.pendingSpeedMult = 0.0f;
+    }
+    void CommitBatch(ActorRef a, ActorInputs& in);
+
+    ActorAccess& access_;
+    ActorRef player_{};
+    Vec3 playerPos_{};
+    ActorStateTable actors_;
+
+    std::shared_ptr<const Settings::Snapshot> settings_;  // see SyncSettings(), never null
+    MovementMath::SmoothingFilter moveFilter_;           // movement smoothing policy, synced with settings_
+
+    CaseSettings caseSettings_;
+    std::uint32_t caseEpoch_ = 0;
+    std::optional<float> weatherMod_[2];  // exterior, interior
+    mutable CaseCacheStats caseStats_;     // the gather counts its lookups
+
+    std::vector<ActorInputs> inputs_;  // gather buffer, parallel to the npc span of the current tick
+    std::vector<std::uint8_t> due_;    // 1 = apply inputs_[i] this tick
+
+    // PrecomputeChunk lanes, packed (only due, in-range NPCs)
+    struct KernelLanes {
+        std::array<std::uint8_t, kSliceChunk> move{}, slope{};  // chunk index per lane
+        std::array<float, kSliceChunk> prev{}, target{}, dt{}, smoothed{};
+        std::array<float, kSliceChunk> x{}, y{}, diag{};
+        std::array<float, kSliceChunk> dz{}, dxy{}, deg{};
+    } lanes_;
+    LodCounts lastLod_;
+
+    std::size_t npcCursor_ = 0;
+    std::size_t slopeCursor_ = 0;  // UpdateSlopeTickNPCsOnly's, between full passes
+    std::size_t lapDone_ = 0;  // NPCs visited since the cursor last wrapped
+    std::uint64_t lapStartMs_ = 0;
+    SliceStats slice_;
+
+    bool revertPending_ = false;
+    std::size_t revertCursor_ = 0;
+
+    std::uint64_t lastNpcApplyMs_ = 0;
+
+    static constexpr float kActivityMoveEps = 1.0f;     // game units per tick
+    static constexpr float kActivityWriteEps = 0.01f;  // residual trickle of a decaying delta is not activity
+    bool active_ = false;
+
+    WriteStats stats_;
+    std::atomic<std::shared_ptr<const StatsView>> statsView_;  // see PublishStats
+
+    std::vector<ActorRef> refreshQueue_;  // this tick's, deduplicated through ActorStateTable::refreshState
+    RefreshStats refreshStats_;
+    bool refreshOwed_ = false;
+};
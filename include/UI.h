@@ -1,4 +1,5 @@
 #pragma once
+#include "Diagnostics.h"
 #include "SKSEMenuFramework.h"
 #include "Settings.h"
 #include "SpeedController.h"
@@ -14,8 +15,10 @@ namespace UI {
         void __stdcall RenderLocations();
         void __stdcall RenderWeather();
         void __stdcall RenderAddons();
+        void __stdcall RenderDiagnostics();
 
         inline std::string saveIcon = FontAwesome::UnicodeToUtf8(0xf0c7) + " Save Settings";
+        inline std::string resetIcon = FontAwesome::UnicodeToUtf8(0xf2f9) + " Reset";
 
         inline std::string smootingAccelerationHeader = FontAwesome::UnicodeToUtf8(0xf624) + " Smoothing / Acceleration";
         inline std::string fixesHeader = FontAwesome::UnicodeToUtf8(0xf54a) + " Fixes";
@@ -0,0 +1,408 @@
+#include "BatchMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "MovementMath.h"
+
+#if DSC_SIMD && (defined(_M_X64) || defined(__x86_64__))
+    #define DSC_BATCH_X64 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define DSC_TARGET_AVX2
+    #else
+        #define DSC_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#else
+    #define DSC_BATCH_X64 0
+#endif
+
+namespace BatchMath {
+    namespace {
+        constexpr float kRadToDeg = 57.29578f;
+        constexpr float kMaxSlopeDeg = 85.0f;
+
+        // ---------------------------------------------------------------------------------------------------
+        // Scalar
+        // ---------------------------------------------------------------------------------------------------
+        template <class P>
+        void SmoothScalar(const P& p, const float* prev, const float* target, const float* dt, float* out,
+                          std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = p.Step(prev[i], target[i], dt[i]);
+        }
+
+        void DiagScalar(const float* x, const float* y, float* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = MovementMath::DiagonalFactor(x[i], y[i]);
+        }
+
+        void SlopeScalar(const float* dz, const float* dxy, float* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = MovementMath::SlopeDegFrom(dz[i], dxy[i]);
+        }
+
+#if DSC_BATCH_X64
+        // Cephes expf / atanf coefficients, shared by both vector widths
+        constexpr float kExpHi = 88.3762626647949f;
+        constexpr float kExpLo = -87.3365447504f;  // keeps 2^n a normal float
+        constexpr float kLog2e = 1.44269504088896341f;
+        constexpr float kExpC1 = 0.693359375f;
+        constexpr float kExpC2 = -2.12194440e-4f;
+        constexpr float kExpP[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                    4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+        constexpr float kTan3Pi8 = 2.414213562373095f;
+        constexpr float kTanPi8 = 0.4142135623730950f;
+        constexpr float kPi2 = 1.5707963267948966f;
+        constexpr float kPi4 = 0.7853981633974483f;
+        constexpr float kAtanP[4] = {8.05374449538e-2f, -1.38776856032e-1f, 1.99777106478e-1f, -3.33329491539e-1f};
+
+        // ---------------------------------------------------------------------------------------------------
+        // SSE2, 4 lanes
+        // ---------------------------------------------------------------------------------------------------
+        inline __m128 Exp4(__m128 x) {
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(kExpLo)), _mm_set1_ps(kExpHi));
+
+            // n = floor(x * log2(e) + 0.5), SSE2 has no floor: truncate and fix up negatives
+            __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(kLog2e)), _mm_set1_ps(0.5f));
+            const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+            fx = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fx), _mm_set1_ps(1.0f)));
+
+            x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kExpC1)));
+            x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kExpC2)));
+            const __m128 z = _mm_mul_ps(x, x);
+
+            __m128 y = _mm_set1_ps(kExpP[0]);
+            for (int k = 1; k < 6; ++k) y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP[k]));
+            y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.0f));
+
+            const __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127)), 23);
+            return _mm_mul_ps(y, _mm_castsi128_ps(e));
+        }
+
+        inline __m128 Atan4(__m128 v) {
+            const __m128 signBit = _mm_set1_ps(-0.0f);
+            const __m128 sign = _mm_and_ps(v, signBit);
+            const __m128 ax = _mm_andnot_ps(signBit, v);
+
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 big = _mm_cmpgt_ps(ax, _mm_set1_ps(kTan3Pi8));
+            const __m128 mid = _mm_andnot_ps(big, _mm_cmpgt_ps(ax, _mm_set1_ps(kTanPi8)));
+
+            const __m128 zBig = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), one), ax);
+            const __m128 zMid = _mm_div_ps(_mm_sub_ps(ax, one), _mm_add_ps(ax, one));
+            __m128 z = _mm_or_ps(_mm_and_ps(big, zBig), _mm_andnot_ps(big, ax));
+            z = _mm_or_ps(_mm_and_ps(mid, zMid), _mm_andnot_ps(mid, z));
+            const __m128 y0 = _mm_or_ps(_mm_and_ps(big, _mm_set1_ps(kPi2)), _mm_and_ps(mid, _mm_set1_ps(kPi4)));
+
+            const __m128 zz = _mm_mul_ps(z, z);
+            __m128 p = _mm_set1_ps(kAtanP[0]);
+            for (int k = 1; k < 4; ++k) p = _mm_add_ps(_mm_mul_ps(p, zz), _mm_set1_ps(kAtanP[k]));
+            p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, zz), z), z);
+
+            return _mm_xor_ps(_mm_add_ps(y0, p), sign);
+        }
+
+        // Vector Step() per smoothing policy, same operation order as the scalar ones
+        inline __m128 Step4(const MovementMath::PassThroughPolicy&, __m128, __m128 target, __m128) { return target; }
+
+        inline __m128 Step4(const MovementMath::ExpoPolicy& p, __m128 prev, __m128 target, __m128 dt) {
+            if (p.instant) return target;
+            const __m128 e = Exp4(_mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), dt), _mm_set1_ps(p.invTau)));
+            __m128 a = _mm_sub_ps(_mm_set1_ps(1.0f), e);
+            a = _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            return _mm_add_ps(prev, _mm_mul_ps(_mm_sub_ps(target, prev), a));
+        }
+
+        inline __m128 Step4(const MovementMath::RatePolicy& p, __m128 prev, __m128 target, __m128 dt) {
+            if (p.unlimited) return target;
+            const __m128 maxStep = _mm_mul_ps(_mm_set1_ps(p.maxPerSec), dt);
+            __m128 d = _mm_sub_ps(target, prev);
+            d = _mm_max_ps(d, _mm_sub_ps(_mm_setzero_ps(), maxStep));
+            d = _mm_min_ps(d, maxStep);
+            return _mm_add_ps(prev, d);
+        }
+
+        inline __m128 Step4(const MovementMath::ExpoThenRatePolicy& p, __m128 prev, __m128 target, __m128 dt) {
+            return Step4(p.rate, prev, Step4(p.expo, prev, target, dt), dt);
+        }
+
+        inline __m128 Diag4(__m128 x, __m128 y) {
+            const __m128 signBit = _mm_set1_ps(-0.0f);
+            const __m128 maxc = _mm_max_ps(_mm_andnot_ps(signBit, x), _mm_andnot_ps(signBit, y));
+            const __m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+            const __m128 f = _mm_min_ps(_mm_set1_ps(1.0f), _mm_div_ps(maxc, mag));
+            const __m128 none =
+                _mm_or_ps(_mm_cmple_ps(mag, _mm_set1_ps(1e-4f)), _mm_cmple_ps(maxc, _mm_setzero_ps()));
+            return _mm_or_ps(_mm_and_ps(none, _mm_set1_ps(1.0f)), _mm_andnot_ps(none, f));
+        }
+
+        inline __m128 Slope4(__m128 dz, __m128 dxy) {
+            const __m128 deg = _mm_mul_ps(Atan4(_mm_div_ps(dz, dxy)), _mm_set1_ps(kRadToDeg));
+            return _mm_min_ps(_mm_max_ps(deg, _mm_set1_ps(-kMaxSlopeDeg)), _mm_set1_ps(kMaxSlopeDeg));
+        }
+
+        // Runs f over full vectors, then once more over a zero-padded copy of the tail
+        template <std::size_t W, class F>
+        inline void ForEachBlock(std::size_t n, const float* const* in, std::size_t nIn, float* out, F&& f) {
+            std::size_t i = 0;
+            for (; i + W <= n; i += W) f(in, i, out + i);
+            if (i == n) return;
+
+            alignas(32) float pad[3][W] = {};
+            alignas(32) float res[W];
+            const float* tail[3] = {pad[0], pad[1], pad[2]};
+            for (std::size_t k = 0; k < nIn; ++k) std::copy(in[k] + i, in[k] + n, pad[k]);
+            f(tail, 0, res);
+            std::copy(res, res + (n - i), out + i);
+        }
+
+        template <class P>
+        void SmoothSSE2(const P& p, const float* prev, const float* target, const float* dt, float* out,
+                        std::size_t n) {
+            const float* in[3] = {prev, target, dt};
+            ForEachBlock<4>(n, in, 3, out, [&](const float* const* s, std::size_t i, float* o) {
+                _mm_storeu_ps(o, Step4(p, _mm_loadu_ps(s[0] + i), _mm_loadu_ps(s[1] + i), _mm_loadu_ps(s[2] + i)));
+            });
+        }
+
+        void DiagSSE2(const float* x, const float* y, float* out, std::size_t n) {
+            const float* in[2] = {x, y};
+            ForEachBlock<4>(n, in, 2, out, [](const float* const* s, std::size_t i, float* o) {
+                _mm_storeu_ps(o, Diag4(_mm_loadu_ps(s[0] + i), _mm_loadu_ps(s[1] + i)));
+            });
+        }
+
+        void SlopeSSE2(const float* dz, const float* dxy, float* out, std::size_t n) {
+            const float* in[2] = {dz, dxy};
+            ForEachBlock<4>(n, in, 2, out, [](const float* const* s, std::size_t i, float* o) {
+                // Padding lanes get dxy = 0 -> inf/nan, clamped and thrown away
+                _mm_storeu_ps(o, Slope4(_mm_loadu_ps(s[0] + i), _mm_loadu_ps(s[1] + i)));
+            });
+        }
+
+        // ---------------------------------------------------------------------------------------------------
+        // AVX2, 8 lanes. Same operation order as the SSE2 path, no FMA, so both agree bit for bit.
+        // ---------------------------------------------------------------------------------------------------
+        DSC_TARGET_AVX2 inline __m256 Exp8(__m256 x) {
+            x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kExpLo)), _mm256_set1_ps(kExpHi));
+
+            __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _mm256_set1_ps(0.5f));
+            fx = _mm256_floor_ps(fx);
+
+            x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kExpC1)));
+            x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kExpC2)));
+            const __m256 z = _mm256_mul_ps(x, x);
+
+            __m256 y = _mm256_set1_ps(kExpP[0]);
+            for (int k = 1; k < 6; ++k) y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP[k]));
+            y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, z), x), _mm256_set1_ps(1.0f));
+
+            const __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127)), 23);
+            return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Atan8(__m256 v) {
+            const __m256 signBit = _mm256_set1_ps(-0.0f);
+            const __m256 sign = _mm256_and_ps(v, signBit);
+            const __m256 ax = _mm256_andnot_ps(signBit, v);
+
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 big = _mm256_cmp_ps(ax, _mm256_set1_ps(kTan3Pi8), _CMP_GT_OQ);
+            const __m256 mid = _mm256_andnot_ps(big, _mm256_cmp_ps(ax, _mm256_set1_ps(kTanPi8), _CMP_GT_OQ));
+
+            const __m256 zBig = _mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), one), ax);
+            const __m256 zMid = _mm256_div_ps(_mm256_sub_ps(ax, one), _mm256_add_ps(ax, one));
+            __m256 z = _mm256_blendv_ps(ax, zBig, big);
+            z = _mm256_blendv_ps(z, zMid, mid);
+            const __m256 y0 =
+                _mm256_or_ps(_mm256_and_ps(big, _mm256_set1_ps(kPi2)), _mm256_and_ps(mid, _mm256_set1_ps(kPi4)));
+
+            const __m256 zz = _mm256_mul_ps(z, z);
+            __m256 p = _mm256_set1_ps(kAtanP[0]);
+            for (int k = 1; k < 4; ++k) p = _mm256_add_ps(_mm256_mul_ps(p, zz), _mm256_set1_ps(kAtanP[k]));
+            p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, zz), z), z);
+
+            return _mm256_xor_ps(_mm256_add_ps(y0, p), sign);
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Step8(const MovementMath::PassThroughPolicy&, __m256, __m256 target, __m256) {
+            return target;
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Step8(const MovementMath::ExpoPolicy& p, __m256 prev, __m256 target,
+                                            __m256 dt) {
+            if (p.instant) return target;
+            const __m256 e = Exp8(_mm256_mul_ps(_mm256_sub_ps(_mm256_setzero_ps(), dt), _mm256_set1_ps(p.invTau)));
+            __m256 a = _mm256_sub_ps(_mm256_set1_ps(1.0f), e);
+            a = _mm256_min_ps(_mm256_max_ps(a, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+            return _mm256_add_ps(prev, _mm256_mul_ps(_mm256_sub_ps(target, prev), a));
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Step8(const MovementMath::RatePolicy& p, __m256 prev, __m256 target,
+                                            __m256 dt) {
+            if (p.unlimited) return target;
+            const __m256 maxStep = _mm256_mul_ps(_mm256_set1_ps(p.maxPerSec), dt);
+            __m256 d = _mm256_sub_ps(target, prev);
+            d = _mm256_max_ps(d, _mm256_sub_ps(_mm256_setzero_ps(), maxStep));
+            d = _mm256_min_ps(d, maxStep);
+            return _mm256_add_ps(prev, d);
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Step8(const MovementMath::ExpoThenRatePolicy& p, __m256 prev, __m256 target,
+                                            __m256 dt) {
+            return Step8(p.rate, prev, Step8(p.expo, prev, target, dt), dt);
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Diag8(__m256 x, __m256 y) {
+            const __m256 signBit = _mm256_set1_ps(-0.0f);
+            const __m256 maxc = _mm256_max_ps(_mm256_andnot_ps(signBit, x), _mm256_andnot_ps(signBit, y));
+            const __m256 mag = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+            const __m256 f = _mm256_min_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(maxc, mag));
+            const __m256 none = _mm256_or_ps(_mm256_cmp_ps(mag, _mm256_set1_ps(1e-4f), _CMP_LE_OQ),
+                                             _mm256_cmp_ps(maxc, _mm256_setzero_ps(), _CMP_LE_OQ));
+            return _mm256_blendv_ps(f, _mm256_set1_ps(1.0f), none);
+        }
+
+        DSC_TARGET_AVX2 inline __m256 Slope8(__m256 dz, __m256 dxy) {
+            const __m256 deg = _mm256_mul_ps(Atan8(_mm256_div_ps(dz, dxy)), _mm256_set1_ps(kRadToDeg));
+            return _mm256_min_ps(_mm256_max_ps(deg, _mm256_set1_ps(-kMaxSlopeDeg)), _mm256_set1_ps(kMaxSlopeDeg));
+        }
+
+        // Explicit loops instead of ForEachBlock: a lambda would not inherit the AVX2 target on GCC/Clang
+        template <class P>
+        DSC_TARGET_AVX2 void SmoothAVX2(const P& p, const float* prev, const float* target, const float* dt,
+                                        float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                _mm256_storeu_ps(out + i, Step8(p, _mm256_loadu_ps(prev + i), _mm256_loadu_ps(target + i),
+                                                _mm256_loadu_ps(dt + i)));
+            }
+            if (i < n) {
+                alignas(32) float a[8] = {}, b[8] = {}, c[8] = {}, r[8];
+                std::copy(prev + i, prev + n, a);
+                std::copy(target + i, target + n, b);
+                std::copy(dt + i, dt + n, c);
+                _mm256_store_ps(r, Step8(p, _mm256_load_ps(a), _mm256_load_ps(b), _mm256_load_ps(c)));
+                std::copy(r, r + (n - i), out + i);
+            }
+            _mm256_zeroupper();
+        }
+
+        DSC_TARGET_AVX2 void DiagAVX2(const float* x, const float* y, float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) _mm256_storeu_ps(out + i, Diag8(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+            if (i < n) {
+                alignas(32) float a[8] = {}, b[8] = {}, r[8];
+                std::copy(x + i, x + n, a);
+                std::copy(y + i, y + n, b);
+                _mm256_store_ps(r, Diag8(_mm256_load_ps(a), _mm256_load_ps(b)));
+                std::copy(r, r + (n - i), out + i);
+            }
+            _mm256_zeroupper();
+        }
+
+        DSC_TARGET_AVX2 void SlopeAVX2(const float* dz, const float* dxy, float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, Slope8(_mm256_loadu_ps(dz + i), _mm256_loadu_ps(dxy + i)));
+            if (i < n) {
+                alignas(32) float a[8] = {}, b[8] = {}, r[8];
+                std::copy(dz + i, dz + n, a);
+                std::copy(dxy + i, dxy + n, b);
+                _mm256_store_ps(r, Slope8(_mm256_load_ps(a), _mm256_load_ps(b)));
+                std::copy(r, r + (n - i), out + i);
+            }
+            _mm256_zeroupper();
+        }
+
+        bool CpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int r[4];
+            __cpuid(r, 1);
+            const bool osxsave = (r[2] & (1 << 27)) != 0;
+            const bool avx = (r[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(r, 7, 0);
+            return (r[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        Isa DetectIsa() {
+#if DSC_BATCH_X64
+            return CpuHasAvx2() ? Isa::AVX2 : Isa::SSE2;
+#else
+            return Isa::Scalar;
+#endif
+        }
+
+        Isa& Current() {
+            static Isa isa = DetectIsa();
+            return isa;
+        }
+    }
+
+    Isa ActiveIsa() { return Current(); }
+
+    const char* IsaName(Isa isa) {
+        switch (isa) {
+            case Isa::SSE2:
+                return "SSE2";
+            case Isa::AVX2:
+                return "AVX2";
+            default:
+                return "Scalar";
+        }
+    }
+
+    Isa ForceIsa(Isa isa) {
+        const Isa best = DetectIsa();
+        Current() = static_cast<Isa>(std::min(static_cast<int>(isa), static_cast<int>(best)));
+        return Current();
+    }
+
+    void Smooth(const MovementMath::SmoothingFilter& filter, const float* prev, const float* target,
+                const float* dtSec, float* out, std::size_t n) {
+        const Isa isa = Current();
+        filter.Visit([&](const auto& p) {
+            switch (isa) {
+#if DSC_BATCH_X64
+                case Isa::AVX2:
+                    return SmoothAVX2(p, prev, target, dtSec, out, n);
+                case Isa::SSE2:
+                    return SmoothSSE2(p, prev, target, dtSec, out, n);
+#endif
+                default:
+                    return SmoothScalar(p, prev, target, dtSec, out, n);
+            }
+        });
+    }
+
+    void DiagonalFactor(const float* x, const float* y, float* out, std::size_t n) {
+        switch (Current()) {
+#if DSC_BATCH_X64
+            case Isa::AVX2:
+                return DiagAVX2(x, y, out, n);
+            case Isa::SSE2:
+                return DiagSSE2(x, y, out, n);
+#endif
+            default:
+                return DiagScalar(x, y, out, n);
+        }
+    }
+
+    void SlopeDeg(const float* dz, const float* dxy, float* out, std::size_t n) {
+        switch (Current()) {
+#if DSC_BATCH_X64
+            case Isa::AVX2:
+                return SlopeAVX2(dz, dxy, out, n);
+            case Isa::SSE2:
+                return SlopeSSE2(dz, dxy, out, n);
+#endif
+            default:
+                return SlopeScalar(dz, dxy, out, n);
+        }
+    }
+}
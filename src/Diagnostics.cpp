@@ -0,0 +1,167 @@
+#include "Diagnostics.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Diag {
+    namespace {
+        struct StageData {
+            std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> timed{0};
+            std::atomic<std::uint64_t> totalNs{0};
+            std::atomic<std::uint64_t> maxNs{0};
+        };
+
+        std::int64_t NowNs() {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        }
+
+        struct Registry {
+            Registry() { resetAtNs.store(NowNs(), std::memory_order_relaxed); }
+
+            std::array<StageData, kStageCount> stages;
+            std::array<std::atomic<std::uint64_t>, kCounterCount> counters{};
+            std::atomic<std::int64_t> resetAtNs{0};
+        };
+
+        Registry& Get() {
+            static Registry r;
+            return r;
+        }
+
+        std::size_t BucketOf(std::uint64_t ns) {
+            if (ns < 8) return static_cast<std::size_t>(ns);
+            const int msb = std::bit_width(ns) - 1;  // >= 3
+            const auto sub = static_cast<std::size_t>((ns >> (msb - 2)) & 3u);
+            return std::min<std::size_t>(kBuckets - 1, 8 + static_cast<std::size_t>(msb - 3) * 4 + sub);
+        }
+
+        // Bucket midpoint in ns
+        double BucketValue(std::size_t idx) {
+            if (idx < 8) return static_cast<double>(idx);
+            const int msb = static_cast<int>((idx - 8) / 4) + 3;
+            const auto sub = static_cast<std::uint64_t>((idx - 8) % 4);
+            const std::uint64_t step = std::uint64_t{1} << (msb - 2);
+            const std::uint64_t lo = (std::uint64_t{1} << msb) + sub * step;
+            return static_cast<double>(lo) + 0.5 * static_cast<double>(step);
+        }
+    }
+
+    const char* StageName(Stage s) {
+        switch (s) {
+            case Stage::Apply:
+                return "Apply";
+            case Stage::ApplyFor:
+                return "ApplyFor";
+            case Stage::CaseToDelta:
+                return "CaseToDelta";
+            case Stage::SlopePenalty:
+                return "UpdateSlopePenalty";
+            case Stage::DiagonalPenalty:
+                return "UpdateDiagonalPenalty";
+            case Stage::ForceSpeedRefresh:
+                return "ForceSpeedRefresh";
+            case Stage::AttackSpeed:
+                return "UpdateAttackSpeed";
+            default:
+                return "?";
+        }
+    }
+
+    const char* CounterName(Counter c) {
+        switch (c) {
+            case Counter::AvWrites:
+                return "AV writes";
+            case Counter::ActorsProcessed:
+                return "Actors processed";
+            case Counter::Refreshes:
+                return "Speed refreshes";
+            default:
+                return "?";
+        }
+    }
+
+    // Writers are the game thread (heartbeat task, event sinks), so plain relaxed load/store instead of locked
+    // read-modify-writes. A rare concurrent writer can drop a sample, which is fine for diagnostics.
+    namespace {
+        inline void Bump(std::atomic<std::uint64_t>& a, std::uint64_t n) {
+            a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+
+    bool CountCall(Stage s) {
+        auto& d = Get().stages[static_cast<std::size_t>(s)];
+        const std::uint64_t n = d.calls.load(std::memory_order_relaxed);
+        d.calls.store(n + 1, std::memory_order_relaxed);
+        return (n % SampleEvery(s)) == 0;
+    }
+
+    void Record(Stage s, std::uint64_t ns) {
+        auto& d = Get().stages[static_cast<std::size_t>(s)];
+        Bump(d.buckets[BucketOf(ns)], 1);
+        Bump(d.timed, 1);
+        Bump(d.totalNs, ns);
+        if (ns > d.maxNs.load(std::memory_order_relaxed)) d.maxNs.store(ns, std::memory_order_relaxed);
+    }
+
+    void Count(Counter c, std::uint64_t n) { Bump(Get().counters[static_cast<std::size_t>(c)], n); }
+
+    Snapshot Take() {
+        auto& r = Get();
+        Snapshot out;
+        out.seconds = std::max(1e-3, (NowNs() - r.resetAtNs.load(std::memory_order_relaxed)) * 1e-9);
+
+        for (std::size_t i = 0; i < kStageCount; ++i) {
+            auto& d = r.stages[i];
+            auto& st = out.stages[i];
+
+            std::array<std::uint64_t, kBuckets> b{};
+            std::uint64_t total = 0;
+            for (std::size_t k = 0; k < kBuckets; ++k) {
+                b[k] = d.buckets[k].load(std::memory_order_relaxed);
+                total += b[k];
+            }
+
+            st.calls = d.calls.load(std::memory_order_relaxed);
+            st.timed = d.timed.load(std::memory_order_relaxed);
+            st.perSec = st.calls / out.seconds;
+            st.meanUs = st.timed ? d.totalNs.load(std::memory_order_relaxed) / 1000.0 / st.timed : 0.0;
+            st.maxUs = d.maxNs.load(std::memory_order_relaxed) / 1000.0;
+            if (total == 0) continue;
+
+            auto pct = [&](double p) {
+                const auto want = static_cast<std::uint64_t>(p * static_cast<double>(total - 1)) + 1;
+                std::uint64_t acc = 0;
+                for (std::size_t k = 0; k < kBuckets; ++k) {
+                    acc += b[k];
+                    if (acc >= want) return BucketValue(k) / 1000.0;
+                }
+                return BucketValue(kBuckets - 1) / 1000.0;
+            };
+            st.p50Us = pct(0.50);
+            st.p95Us = pct(0.95);
+            st.p99Us = pct(0.99);
+        }
+
+        for (std::size_t i = 0; i < kCounterCount; ++i) {
+            out.counters[i].total = r.counters[i].load(std::memory_order_relaxed);
+            out.counters[i].perSec = out.counters[i].total / out.seconds;
+        }
+        return out;
+    }
+
+    void Reset() {
+        auto& r = Get();
+        for (auto& d : r.stages) {
+            for (auto& b : d.buckets) b.store(0, std::memory_order_relaxed);
+            d.calls.store(0, std::memory_order_relaxed);
+            d.timed.store(0, std::memory_order_relaxed);
+            d.totalNs.store(0, std::memory_order_relaxed);
+            d.maxNs.store(0, std::memory_order_relaxed);
+        }
+        for (auto& c : r.counters) c.store(0, std::memory_order_relaxed);
+        r.resetAtNs.store(NowNs(), std::memory_order_relaxed);
+    }
+}
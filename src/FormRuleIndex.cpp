@@ -0,0 +1,142 @@
+#include "FormRuleIndex.h"
+
+#include "Settings.h"
+
+namespace {
+    template <class T>
+    T* Resolve(const Settings::FormSpec& fs) {
+        auto* dh = RE::TESDataHandler::GetSingleton();
+        if (!dh) return nullptr;
+        return dh->LookupForm<T>(fs.id, fs.plugin);
+    }
+}
+
+void FormRuleIndex::EnsureCurrent(const Settings::FormRules& rules) {
+    if (built_ && rules.revision == builtRevision_) return;
+    Rebuild(rules);
+}
+
+void FormRuleIndex::Rebuild(const Settings::FormRules& rules) {
+    builtRevision_ = rules.revision;
+    built_ = true;
+
+    location_.clear();
+    weather_.clear();
+    ResolveBeastRaces(rules.beastRaces);
+
+    std::unordered_map<RE::FormID, Rule> specific;
+    std::unordered_map<RE::FormID, Rule> keyword;
+
+    std::uint32_t order = 0;
+    for (auto& fs : rules.locationSpecific) {
+        if (auto* l = Resolve<RE::BGSLocation>(fs)) {
+            specific.try_emplace(l->GetFormID(), Rule{fs.value, order});
+        }
+        ++order;
+    }
+
+    order = 0;
+    for (auto& fs : rules.locationType) {
+        if (auto* kw = Resolve<RE::BGSKeyword>(fs)) {
+            keyword.try_emplace(kw->GetFormID(), Rule{fs.value, order});
+        }
+        ++order;
+    }
+
+    for (auto& fs : rules.weatherSpecific) {
+        if (auto* w = Resolve<RE::TESWeather>(fs)) {
+            weather_.try_emplace(w->GetFormID(), fs.value);
+        }
+    }
+
+    // Flatten every location once: own specific rule, then own keywords, then the same for parentLoc upwards.
+    // A hold/city rule thereby applies to all of its sub-locations unless they have a rule of their own.
+    std::size_t scanned = 0;
+    if (!specific.empty() || !keyword.empty()) {
+        if (auto* dh = RE::TESDataHandler::GetSingleton()) {
+            for (auto* loc : dh->GetFormArray<RE::BGSLocation>()) {
+                if (!loc) continue;
+                ++scanned;
+                if (auto v = ResolveChain(loc, specific, keyword)) {
+                    location_.emplace(loc->GetFormID(), *v);
+                }
+            }
+        }
+    }
+
+    logger::debug("[FormRuleIndex] {} rules -> {} of {} locations affected, {} weather rules",
+                  specific.size() + keyword.size(), location_.size(), scanned, weather_.size());
+}
+
+// Entries with a '|' are form specs, everything else is matched against the race editor IDs once here
+void FormRuleIndex::ResolveBeastRaces(const std::vector<std::string>& entries) {
+    beastRaces_.clear();
+
+    std::vector<const std::string*> editorIDs;
+    for (auto& e : entries) {
+        if (e.find('|') == std::string::npos) {
+            editorIDs.push_back(&e);
+            continue;
+        }
+        Settings::FormSpec fs;
+        if (!Settings::ParseFormSpec(e, fs.plugin, fs.id)) continue;
+        if (auto* r = Resolve<RE::TESRace>(fs)) beastRaces_.insert(r->GetFormID());
+    }
+
+    if (!editorIDs.empty()) {
+        if (auto* dh = RE::TESDataHandler::GetSingleton()) {
+            for (auto* r : dh->GetFormArray<RE::TESRace>()) {
+                const char* id = r ? r->GetFormEditorID() : nullptr;
+                if (!id || !*id) continue;
+                for (auto* want : editorIDs) {
+                    if (_stricmp(id, want->c_str()) == 0) {
+                        beastRaces_.insert(r->GetFormID());
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    logger::debug("[FormRuleIndex] {} beast races from {} entries", beastRaces_.size(), entries.size());
+}
+
+std::optional<float> FormRuleIndex::ResolveChain(const RE::BGSLocation* loc,
+                                                 const std::unordered_map<RE::FormID, Rule>& specific,
+                                                 const std::unordered_map<RE::FormID, Rule>& keyword) {
+    // Depth cap guards against broken (cyclic) parent links from mods
+    for (int depth = 0; loc && depth < kMaxParentDepth; ++depth, loc = loc->parentLoc) {
+        if (auto it = specific.find(loc->GetFormID()); it != specific.end()) {
+            return it->second.value;
+        }
+
+        if (keyword.empty() || !loc->keywords) continue;
+
+        const Rule* best = nullptr;
+        for (std::uint32_t i = 0; i < loc->numKeywords; ++i) {
+            const RE::BGSKeyword* kw = loc->keywords[i];
+            if (!kw) continue;
+            if (auto it = keyword.find(kw->GetFormID()); it != keyword.end()) {
+                if (!best || it->second.order < best->order) best = &it->second;
+            }
+        }
+        if (best) return best->value;
+    }
+    return std::nullopt;
+}
+
+std::optional<float> FormRuleIndex::LocationValue(const RE::BGSLocation* loc) const {
+    if (!loc || location_.empty()) return std::nullopt;
+    if (auto it = location_.find(loc->GetFormID()); it != location_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<float> FormRuleIndex::WeatherValue(const RE::TESWeather* w) const {
+    if (!w || weather_.empty()) return std::nullopt;
+    if (auto it = weather_.find(w->GetFormID()); it != weather_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,115 @@
+#include "GraphVarCache.h"
+
+#include <array>
+
+namespace {
+    // Interned once on first use (the string pool does not exist yet during static init)
+    struct Names {
+        std::array<std::array<RE::BSFixedString, 2>, 3> axes{{
+            {"MoveX", "MoveY"},
+            {"SpeedSide", "SpeedForward"},
+            {"Strafe", "Forward"},
+        }};
+        std::array<RE::BSFixedString, 3> sprint{"IsSprinting", "bIsSprinting", "bSprint"};
+        std::array<RE::BSFixedString, 4> beast{"IsWerewolf", "bIsWerewolf", "IsVampireLord", "bIsVampireLord"};
+        std::array<RE::BSFixedString, 4> animSpeed{"fAnimSpeedMult", "AnimSpeedMult", "AnimSpeed", "fSprintSpeedMult"};
+    };
+
+    const Names& GetNames() {
+        static const Names n;
+        return n;
+    }
+
+    // Behavior graph project of the actor's race and sex, the race itself if it has no project path
+    const void* GraphKey(const RE::Actor* a) {
+        auto* race = a->GetRace();
+        if (!race) return nullptr;
+        auto* npc = a->GetActorBase();
+        const auto sex = (npc && npc->GetSex() == RE::SEXES::kFemale) ? RE::SEXES::kFemale : RE::SEXES::kMale;
+        const auto& model = race->behaviorGraphs[sex].model;
+        if (!model.empty()) return model.data();
+        return race;
+    }
+
+    template <std::size_t N>
+    std::uint8_t BoolMask(const RE::Actor* a, const std::array<RE::BSFixedString, N>& names) {
+        std::uint8_t mask = 0;
+        bool b = false;
+        for (std::size_t i = 0; i < N; ++i) {
+            if (a->GetGraphVariableBool(names[i], b)) mask |= static_cast<std::uint8_t>(1u << i);
+        }
+        return mask;
+    }
+
+    template <std::size_t N>
+    bool AnyTrue(const RE::Actor* a, const std::array<RE::BSFixedString, N>& names, std::uint8_t mask) {
+        bool b = false;
+        for (std::size_t i = 0; i < N; ++i) {
+            if ((mask & (1u << i)) && a->GetGraphVariableBool(names[i], b) && b) return true;
+        }
+        return false;
+    }
+}
+
+const GraphVarCache::Binding* GraphVarCache::Find(const RE::Actor* a) {
+    if (!a) return nullptr;
+    const void* key = GraphKey(a);
+    if (!key) return nullptr;
+
+    if (auto it = bindings_.find(key); it != bindings_.end()) return &it->second;
+
+    // Without 3D every probe fails, that says nothing about the graph
+    if (!a->Is3DLoaded()) return nullptr;
+
+    const auto& n = GetNames();
+    Binding b;
+    float f = 0.0f;
+    for (std::size_t i = 0; i < n.axes.size() && b.axes < 0; ++i) {
+        if (a->GetGraphVariableFloat(n.axes[i][0], f) || a->GetGraphVariableFloat(n.axes[i][1], f)) {
+            b.axes = static_cast<std::int8_t>(i);
+        }
+    }
+    b.sprint = BoolMask(a, n.sprint);
+    b.beast = BoolMask(a, n.beast);
+    for (std::size_t i = 0; i < n.animSpeed.size(); ++i) {
+        if (a->GetGraphVariableFloat(n.animSpeed[i], f)) b.animSpeed |= static_cast<std::uint8_t>(1u << i);
+    }
+
+    return &bindings_.emplace(key, b).first->second;
+}
+
+bool GraphVarCache::GetMoveAxes(const RE::Actor* a, float& outX, float& outY) {
+    const Binding* b = Find(a);
+    if (!b || b->axes < 0) return false;
+
+    const auto& pair = GetNames().axes[b->axes];
+    float x = 0.0f, y = 0.0f;
+    const bool okX = a->GetGraphVariableFloat(pair[0], x);
+    const bool okY = a->GetGraphVariableFloat(pair[1], y);
+    if (!okX && !okY) return false;
+    outX = x;
+    outY = y;
+    return true;
+}
+
+bool GraphVarCache::IsSprinting(const RE::Actor* a) {
+    const Binding* b = Find(a);
+    return b && b->sprint && AnyTrue(a, GetNames().sprint, b->sprint);
+}
+
+bool GraphVarCache::HasBeastFlag(const RE::Actor* a) {
+    const Binding* b = Find(a);
+    return b && b->beast && AnyTrue(a, GetNames().beast, b->beast);
+}
+
+bool GraphVarCache::SetAnimSpeed(RE::Actor* a, float v) {
+    const Binding* b = Find(a);
+    if (!b || !b->animSpeed) return false;
+
+    const auto& names = GetNames().animSpeed;
+    bool any = false;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (b->animSpeed & (1u << i)) any |= a->SetGraphVariableFloat(names[i], v);
+    }
+    return any;
+}
@@ -0,0 +1,112 @@
+#include "InputActionMap.h"
+
+#include <charconv>
+
+namespace {
+    std::string_view Trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    template <class F>
+    void ForEachItem(std::string_view list, char sep, F&& f) {
+        while (!list.empty()) {
+            const auto cut = list.find(sep);
+            const auto item = Trim(list.substr(0, cut));
+            if (!item.empty()) f(item);
+            if (cut == std::string_view::npos) break;
+            list.remove_prefix(cut + 1);
+        }
+    }
+}
+
+InputActionMap InputActionMap::Build(const Config& c) {
+    InputActionMap m;
+
+    // Movement, the vanilla names plus the ones control mods use
+    m.BindEvent("Forward", kForward);
+    m.BindEvent("Back", kBack);
+    for (auto n : {"Strafe Left", "StrafeLeft", "MoveLeft"}) m.BindEvent(n, kStrafeLeft);
+    for (auto n : {"Strafe Right", "StrafeRight", "MoveRight"}) m.BindEvent(n, kStrafeRight);
+
+    m.BindEvents(c.sprintEvents, kSprint);
+    m.BindEvents(c.toggleEvents, kToggleJogging);
+
+    if (c.toggleKey != 0) m.BindKeys(&c.toggleKey, 1, kToggleJogging);
+
+    ForEachItem(c.toggleChords, ',', [&](std::string_view chord) {
+        std::array<std::uint32_t, kMaxChordKeys> keys{};
+        std::size_t n = 0;
+        bool ok = true;
+        ForEachItem(chord, '+', [&](std::string_view key) {
+            std::uint32_t code = 0;
+            const auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), code);
+            if (ec != std::errc{} || end != key.data() + key.size() || code == 0 || n == keys.size()) {
+                ok = false;
+                return;
+            }
+            keys[n++] = code;
+        });
+        if (ok && n > 0) m.BindKeys(keys.data(), n, kToggleJogging);
+    });
+
+    return m;
+}
+
+void InputActionMap::BindEvent(std::string_view name, Actions a) {
+    RE::BSFixedString interned(name);
+    for (auto& e : events_) {
+        if (e.name.data() == interned.data()) {
+            e.actions |= a;
+            return;
+        }
+    }
+    events_.push_back({std::move(interned), a});
+}
+
+void InputActionMap::BindEvents(const std::string& list, Actions a) {
+    ForEachItem(list, ',', [&](std::string_view name) { BindEvent(name, a); });
+}
+
+void InputActionMap::BindKeys(const std::uint32_t* keys, std::size_t n, Actions a) {
+    KeyBinding b;
+    for (std::size_t i = 0; i < n; ++i) {
+        // The trigger key needs no tracking, only the ones that have to be held before it
+        if (i + 1 < n && TrackedIndex(keys[i]) < 0) {
+            if (tracked_.size() == kMaxTrackedKeys) return;
+            tracked_.push_back(keys[i]);
+        }
+        b.keys[b.count++] = keys[i];
+    }
+    b.actions = a;
+    keys_.push_back(b);
+}
+
+int InputActionMap::TrackedIndex(std::uint32_t code) const {
+    for (std::size_t i = 0; i < tracked_.size(); ++i) {
+        if (tracked_[i] == code) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+InputActionMap::Actions InputActionMap::ForKey(std::uint32_t idCode, bool down, bool press, KeyState& held) const {
+    if (const int i = TrackedIndex(idCode); i >= 0) {
+        if (down)
+            held |= KeyState{1} << i;
+        else
+            held &= ~(KeyState{1} << i);
+    }
+    if (!press) return 0;
+
+    Actions out = 0;
+    for (const auto& b : keys_) {
+        if (b.keys[b.count - 1] != idCode) continue;
+        bool all = true;
+        for (std::uint8_t k = 0; k + 1 < b.count && all; ++k) {
+            all = (held >> TrackedIndex(b.keys[k])) & 1u;
+        }
+        if (all) out |= b.actions;
+    }
+    return out;
+}
@@ -2,12 +2,58 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iterator>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <tuple>
 
+// Get nlohmann/json from: https://github.com/nlohmann/json
+#include "nlohmann/json.hpp"
 using nlohmann::json;
 
 static float clampf(float v, float lo, float hi) { return std::max(lo, std::min(hi, v)); }
 
+// The settings file as of the last load or save, LoadFromJsonIfChanged compares against it. Its parsed document is
+// kept too, an unchanged file is re-applied from it without reading or parsing again.
+struct FileStamp {
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type mtime{};
+    std::uint64_t hash = 0;
+    bool valid = false;
+};
+static std::mutex stampMx;  // saves come from the UI thread, loads from the game thread
+static FileStamp stamp;
+static json lastDoc;
+
+static std::uint64_t HashText(std::string_view s) {
+    std::uint64_t h = 0xcbf29ce484222325ull;  // FNV-1a
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static bool ReadText(const std::filesystem::path& file, std::string& out) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) return false;
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+static void Remember(const std::filesystem::path& file, const std::string& text, json doc) {
+    std::error_code ec;
+    FileStamp s;
+    s.size = text.size();
+    s.mtime = std::filesystem::last_write_time(file, ec);
+    s.hash = HashText(text);
+    s.valid = !ec;
+    std::lock_guard lk(stampMx);
+    stamp = s;
+    lastDoc = std::move(doc);
+}
+
 std::filesystem::path Settings::DefaultPath() {
     return std::filesystem::path("Data") / "SKSE" / "Plugins" / "SpeedController.json";
 }
@@ -27,6 +73,7 @@ bool Settings::ParseFormSpec(const std::string& spec, std::string& plugin, std::
 }
 
 bool Settings::SaveToJson(const std::filesystem::path& file) {
+    const auto wlk = LockWrites();
     nlohmann::json j;
     j["kReduceOutOfCombat"] = reduceOutOfCombat.load();
     j["kReduceJoggingOutOfCombat"] = reduceJoggingOutOfCombat.load();
@@ -36,6 +83,7 @@ bool Settings::SaveToJson(const std::filesystem::path& file) {
     j["kNoReductionInCombat"] = noReductionInCombat.load();
     j["kToggleSpeedKey"] = toggleSpeedKey.load();
     j["kToggleSpeedEvent"] = toggleSpeedEvent;
+    j["kToggleSpeedChords"] = toggleSpeedChords;
     j["kSprintEventName"] = sprintEventName;
 
     j["kAttackSpeedEnabled"] = attackSpeedEnabled.load();
@@ -43,7 +91,11 @@ bool Settings::SaveToJson(const std::filesystem::path& file) {
     j["kEnableSpeedScalingForNPCs"] = enableSpeedScalingForNPCs.load();
     j["kEnableDiagonalSpeedFix"] = enableDiagonalSpeedFix.load();
     j["kEnableDiagonalSpeedFixForNPCs"] = enableDiagonalSpeedFixForNPCs.load();
+    j["kInputDeadzone"] = inputDeadzone.load();
+    j["kInputRadialDeadzone"] = inputRadialDeadzone.load();
+    j["kInputAxisStep"] = inputAxisStep.load();
     j["kIgnoreBeastForms"] = ignoreBeastForms.load();
+    j["kBeastRaces"] = beastRaces;
     j["kAttackBase"] = attackBase.load();
     j["kWeightPivot"] = weightPivot.load();
     j["kWeightSlope"] = weightSlope.load();
@@ -99,6 +151,9 @@ bool Settings::SaveToJson(const std::filesystem::path& file) {
     j["kSprintAnimMin"] = sprintAnimMin.load();
     j["kSprintAnimMax"] = sprintAnimMax.load();
     j["kEventDebounceMs"] = eventDebounceMs.load();
+    j["kHeartbeatIdleMs"] = heartbeatIdleMs.load();
+    j["kRefreshMinIntervalMs"] = refreshMinIntervalMs.load();
+    j["kNPCRefreshMinIntervalMs"] = npcRefreshMinIntervalMs.load();
 
     j["kSlopeEnabled"] = slopeEnabled.load();
     j["kSlopeAffectsNPCs"] = slopeAffectsNPCs.load();
@@ -125,6 +180,13 @@ bool Settings::SaveToJson(const std::filesystem::path& file) {
     j["kArmorWeightSlopeAtk"] = armorWeightSlopeAtk.load();
     j["kNpcRadius"] = npcRadius.load();
     j["kNpcPercentOfPlayer"] = npcPercentOfPlayer.load();
+    j["kNpcLodEnabled"] = npcLodEnabled.load();
+    j["kNpcLodNearRadius"] = npcLodNearRadius.load();
+    j["kNpcLodMidRadius"] = npcLodMidRadius.load();
+    j["kNpcLodMidInterval"] = npcLodMidInterval.load();
+    j["kNpcLodHysteresis"] = npcLodHysteresis.load();
+    j["kNpcBudgetUs"] = npcBudgetUs.load();
+    j["kNpcMaxStaleMs"] = npcMaxStaleMs.load();
     j["kWeatherEnabled"] = weatherEnabled.load();
     j["kWeatherAffects"] = (weatherAffects == WeatherAffects::AllStates) ? "all" : "default";
     j["kWeatherMode"] = (weatherMode == WeatherMode::Add) ? "add" : "replace";
@@ -167,24 +229,79 @@ bool Settings::SaveToJson(const std::filesystem::path& file) {
     j["kDwBuildUpPerSec"] = dwBuildUpPerSec.load();
     j["kDwDryPerSec"] = dwDryPerSec.load();
 
-    std::ofstream out(file);
-    if (!out.is_open()) return false;
-    out << j.dump(4);
+    // Binary, so the bytes on disk are the ones remembered (no CRLF translation)
+    const std::string text = j.dump(4);
+    {
+        std::ofstream out(file, std::ios::binary);
+        if (!out.is_open()) return false;
+        out << text;
+        if (!out.flush()) return false;
+    }
+    Remember(file, text, std::move(j));
     return true;
 }
 
-
-bool Settings::LoadFromJson(const std::filesystem::path& file) {
-    std::ifstream in(file);
-    if (!in.is_open()) {
-        return false;
-    }
-    json j;
+static bool ParseText(const std::string& text, json& out) {
     try {
-        in >> j;
+        out = json::parse(text);
+        return true;
     } catch (...) {
         return false;
     }
+}
+
+bool Settings::LoadFromJson(const std::filesystem::path& file) {
+    std::string text;
+    json doc;
+    if (!ReadText(file, text) || !ParseText(text, doc)) return false;
+    Remember(file, text, std::move(doc));
+    ApplyLastJson();
+    return true;
+}
+
+Settings::LoadResult Settings::LoadFromJsonIfChanged(const std::filesystem::path& file) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(file, ec);
+    if (ec) return LoadResult::Failed;
+    const auto mtime = std::filesystem::last_write_time(file, ec);
+    if (ec) return LoadResult::Failed;
+
+    bool same = false;
+    {
+        std::lock_guard lk(stampMx);
+        same = stamp.valid && stamp.size == size && stamp.mtime == mtime;
+    }
+    std::string text;
+    if (!same) {
+        if (!ReadText(file, text)) return LoadResult::Failed;
+        const std::uint64_t hash = HashText(text);
+        // Touched or copied over with the same content
+        std::lock_guard lk(stampMx);
+        same = stamp.valid && stamp.size == text.size() && stamp.hash == hash;
+        if (same) stamp.mtime = mtime;
+    }
+
+    if (!same) {
+        json doc;
+        if (!ParseText(text, doc)) return LoadResult::Failed;
+        Remember(file, text, std::move(doc));
+    }
+    // Applied either way, so a load still drops unsaved menu edits and publishes
+    ApplyLastJson();
+    return same ? LoadResult::Unchanged : LoadResult::Loaded;
+}
+
+void Settings::ApplyLastJson() {
+    const auto wlk = LockWrites();  // before stampMx, the menu saves while holding it
+    std::lock_guard lk(stampMx);
+    json& j = lastDoc;
+
+    // Only a real change of the rule lists moves formRulesRevision, a new one rebuilds every resolved lookup and
+    // starts a new case-cache epoch
+    auto ruleLists = [] {
+        return std::make_tuple(reduceInLocationType, reduceInLocationSpecific, reduceInWeatherSpecific, beastRaces);
+    };
+    const auto prevRules = ruleLists();
 
     if (j.contains("kReduceOutOfCombat")) {
         float v = j["kReduceOutOfCombat"].get<float>();
@@ -218,6 +335,9 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
         std::string v = j["kToggleSpeedEvent"].get<std::string>();
         toggleSpeedEvent = v;
     }
+    if (j.contains("kToggleSpeedChords") && j["kToggleSpeedChords"].is_string()) {
+        toggleSpeedChords = j["kToggleSpeedChords"].get<std::string>();
+    }
     if (j.contains("kSprintEventName")) {
         std::string v = j["kSprintEventName"].get<std::string>();
         sprintEventName = v;
@@ -235,6 +355,12 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
     if (j.contains("kIgnoreBeastForms")) {
         ignoreBeastForms = j["kIgnoreBeastForms"].get<bool>();
     }
+    if (j.contains("kBeastRaces") && j["kBeastRaces"].is_array()) {
+        beastRaces.clear();
+        for (auto& e : j["kBeastRaces"]) {
+            if (e.is_string() && !e.get_ref<const std::string&>().empty()) beastRaces.push_back(e.get<std::string>());
+        }
+    }
     if (j.contains("kAttackBase")) {
         attackBase = j["kAttackBase"].get<float>();
     }
@@ -262,6 +388,15 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
     if (j.contains("kEnableDiagonalSpeedFixForNPCs")) {
         enableDiagonalSpeedFixForNPCs = j["kEnableDiagonalSpeedFixForNPCs"].get<bool>();
     }
+    if (j.contains("kInputDeadzone")) {
+        inputDeadzone = clampf(j["kInputDeadzone"].get<float>(), 0.0f, 0.9f);
+    }
+    if (j.contains("kInputRadialDeadzone")) {
+        inputRadialDeadzone = j["kInputRadialDeadzone"].get<bool>();
+    }
+    if (j.contains("kInputAxisStep")) {
+        inputAxisStep = clampf(j["kInputAxisStep"].get<float>(), 0.0f, 0.5f);
+    }
     if (j.contains("kSmoothingEnabled")) {
         smoothingEnabled = j["kSmoothingEnabled"].get<bool>();
     }
@@ -324,6 +459,15 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
     if (j.contains("kEventDebounceMs")) {
         eventDebounceMs = j["kEventDebounceMs"].get<int>();
     }
+    if (j.contains("kHeartbeatIdleMs")) {
+        heartbeatIdleMs = std::clamp(j["kHeartbeatIdleMs"].get<int>(), 0, 1000);
+    }
+    if (j.contains("kRefreshMinIntervalMs")) {
+        refreshMinIntervalMs = std::clamp(j["kRefreshMinIntervalMs"].get<int>(), 0, 500);
+    }
+    if (j.contains("kNPCRefreshMinIntervalMs")) {
+        npcRefreshMinIntervalMs = std::clamp(j["kNPCRefreshMinIntervalMs"].get<int>(), 0, 500);
+    }
 
     reduceInLocationType.clear();
     reduceInLocationSpecific.clear();
@@ -450,6 +594,27 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
         float v = j["kNpcPercentOfPlayer"].get<float>();
         npcPercentOfPlayer = clampf(v, 0.0f, 200.0f);
     }
+    if (j.contains("kNpcLodEnabled")) {
+        npcLodEnabled = j["kNpcLodEnabled"].get<bool>();
+    }
+    if (j.contains("kNpcLodNearRadius")) {
+        npcLodNearRadius = std::clamp(j["kNpcLodNearRadius"].get<int>(), 0, 16384);
+    }
+    if (j.contains("kNpcLodMidRadius")) {
+        npcLodMidRadius = std::clamp(j["kNpcLodMidRadius"].get<int>(), 0, 16384);
+    }
+    if (j.contains("kNpcLodMidInterval")) {
+        npcLodMidInterval = std::clamp(j["kNpcLodMidInterval"].get<int>(), 1, 60);
+    }
+    if (j.contains("kNpcLodHysteresis")) {
+        npcLodHysteresis = std::clamp(j["kNpcLodHysteresis"].get<int>(), 0, 2048);
+    }
+    if (j.contains("kNpcBudgetUs")) {
+        npcBudgetUs = std::clamp(j["kNpcBudgetUs"].get<int>(), 0, 100000);
+    }
+    if (j.contains("kNpcMaxStaleMs")) {
+        npcMaxStaleMs = std::clamp(j["kNpcMaxStaleMs"].get<int>(), 33, 5000);
+    }
     if (j.contains("kWeatherPresets")) {
         loadList(j["kWeatherPresets"], reduceInWeatherSpecific);
     }
@@ -531,5 +696,6 @@ bool Settings::LoadFromJson(const std::filesystem::path& file) {
             scaleCompMode = (v == 1) ? ScaleCompMode::Inverse : ScaleCompMode::Additive;
         }
     }
-    return true;
+    if (ruleLists() != prevRules) MarkFormRulesChanged();
+    Publish();
 }
@@ -0,0 +1,159 @@
+#include "Settings.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// Snapshot publishing lives apart from Settings.cpp, so the engine-free core and the tools link it without JSON.
+
+// Copies the statics. The rule lists are only copied when formRulesRevision moved past prevRules.
+static Settings::Snapshot CaptureSnapshot(const std::shared_ptr<const Settings::FormRules>& prevRules) {
+    using S = Settings;
+    Settings::Snapshot s;
+    s.slopeEnabled = S::slopeEnabled.load();
+    s.slopeAffectsNPCs = S::slopeAffectsNPCs.load();
+    s.slopeUphillPerDeg = S::slopeUphillPerDeg.load();
+    s.slopeDownhillPerDeg = S::slopeDownhillPerDeg.load();
+    s.slopeMaxAbs = S::slopeMaxAbs.load();
+    s.slopeTau = S::slopeTau.load();
+    s.slopeMethod = S::slopeMethod.load();
+    s.slopeLookbackUnits = S::slopeLookbackUnits.load();
+    s.slopeMaxHistorySec = S::slopeMaxHistorySec.load();
+    s.slopeMinXYPerFrame = S::slopeMinXYPerFrame.load();
+    s.slopeMedianN = S::slopeMedianN.load();
+    s.slopeClampEnabled = S::slopeClampEnabled.load();
+    s.slopeMinFinal = S::slopeMinFinal.load();
+    s.slopeMaxFinal = S::slopeMaxFinal.load();
+    s.minFinalSpeedMult = S::minFinalSpeedMult.load();
+    s.smoothingEnabled = S::smoothingEnabled.load();
+    s.smoothingAffectsNPCs = S::smoothingAffectsNPCs.load();
+    s.smoothingBypassOnStateChange = S::smoothingBypassOnStateChange.load();
+    s.smoothingMode = S::smoothingMode;
+    s.smoothingHalfLifeMs = S::smoothingHalfLifeMs.load();
+    s.smoothingMaxChangePerSecond = S::smoothingMaxChangePerSecond.load();
+    s.enableSpeedScalingForNPCs = S::enableSpeedScalingForNPCs.load();
+    s.ignoreBeastForms = S::ignoreBeastForms.load();
+    s.enableDiagonalSpeedFix = S::enableDiagonalSpeedFix.load();
+    s.enableDiagonalSpeedFixForNPCs = S::enableDiagonalSpeedFixForNPCs.load();
+    s.inputDeadzone = S::inputDeadzone.load();
+    s.inputRadialDeadzone = S::inputRadialDeadzone.load();
+    s.inputAxisStep = S::inputAxisStep.load();
+    s.scaleCompEnabled = S::scaleCompEnabled.load();
+    s.scaleCompOnlyBelowOne = S::scaleCompOnlyBelowOne.load();
+    s.scaleCompPerUnitSM = S::scaleCompPerUnitSM.load();
+    s.scaleCompMode = S::scaleCompMode;
+    s.reduceOutOfCombat = S::reduceOutOfCombat.load();
+    s.reduceJoggingOutOfCombat = S::reduceJoggingOutOfCombat.load();
+    s.reduceDrawn = S::reduceDrawn.load();
+    s.reduceSneak = S::reduceSneak.load();
+    s.increaseSprinting = S::increaseSprinting.load();
+    s.noReductionInCombat = S::noReductionInCombat.load();
+    s.toggleSpeedKey = S::toggleSpeedKey.load();
+    s.toggleSpeedEvent = S::toggleSpeedEvent;
+    s.toggleSpeedChords = S::toggleSpeedChords;
+    s.sprintEventName = S::sprintEventName;
+    s.attackSpeedEnabled = S::attackSpeedEnabled.load();
+    s.attackOnlyWhenDrawn = S::attackOnlyWhenDrawn.load();
+    s.sprintAffectsCombat = S::sprintAffectsCombat.load();
+    s.attackBase = S::attackBase.load();
+    s.weightPivot = S::weightPivot.load();
+    s.weightSlope = S::weightSlope.load();
+    s.usePlayerScale = S::usePlayerScale.load();
+    s.scaleSlope = S::scaleSlope.load();
+    s.minAttackMult = S::minAttackMult.load();
+    s.maxAttackMult = S::maxAttackMult.load();
+    s.syncSprintAnimToSpeed = S::syncSprintAnimToSpeed.load();
+    s.onlySlowDown = S::onlySlowDown.load();
+    s.sprintAnimMin = S::sprintAnimMin.load();
+    s.sprintAnimMax = S::sprintAnimMax.load();
+    s.sprintAnimOwnSmoothing = S::sprintAnimOwnSmoothing.load();
+    s.sprintAnimSmoothingMode = S::sprintAnimSmoothingMode.load();
+    s.sprintAnimTau = S::sprintAnimTau.load();
+    s.sprintAnimRatePerSec = S::sprintAnimRatePerSec.load();
+    s.armorAffectsMovement = S::armorAffectsMovement.load();
+    s.armorAffectsAttackSpeed = S::armorAffectsAttackSpeed.load();
+    s.useMaxArmorWeight = S::useMaxArmorWeight.load();
+    s.armorWeightPivot = S::armorWeightPivot.load();
+    s.armorWeightSlopeSM = S::armorWeightSlopeSM.load();
+    s.armorMoveMin = S::armorMoveMin.load();
+    s.armorMoveMax = S::armorMoveMax.load();
+    s.armorWeightSlopeAtk = S::armorWeightSlopeAtk.load();
+    s.eventDebounceMs = S::eventDebounceMs.load();
+    s.heartbeatIdleMs = S::heartbeatIdleMs.load();
+    s.refreshMinIntervalMs = S::refreshMinIntervalMs.load();
+    s.npcRefreshMinIntervalMs = S::npcRefreshMinIntervalMs.load();
+    s.npcRadius = S::npcRadius.load();
+    s.npcPercentOfPlayer = S::npcPercentOfPlayer.load();
+    s.npcLodEnabled = S::npcLodEnabled.load();
+    s.npcLodNearRadius = S::npcLodNearRadius.load();
+    s.npcLodMidRadius = S::npcLodMidRadius.load();
+    s.npcLodMidInterval = S::npcLodMidInterval.load();
+    s.npcLodHysteresis = S::npcLodHysteresis.load();
+    s.npcBudgetUs = S::npcBudgetUs.load();
+    s.npcMaxStaleMs = S::npcMaxStaleMs.load();
+    s.healthEnabled = S::healthEnabled.load();
+    s.healthThresholdPct = S::healthThresholdPct.load();
+    s.healthReducePct = S::healthReducePct.load();
+    s.healthSmoothWidthPct = S::healthSmoothWidthPct.load();
+    s.staminaEnabled = S::staminaEnabled.load();
+    s.staminaThresholdPct = S::staminaThresholdPct.load();
+    s.staminaReducePct = S::staminaReducePct.load();
+    s.staminaSmoothWidthPct = S::staminaSmoothWidthPct.load();
+    s.magickaEnabled = S::magickaEnabled.load();
+    s.magickaThresholdPct = S::magickaThresholdPct.load();
+    s.magickaReducePct = S::magickaReducePct.load();
+    s.magickaSmoothWidthPct = S::magickaSmoothWidthPct.load();
+    s.dwEnabled = S::dwEnabled.load();
+    s.dwSlopeFeatureEnabled = S::dwSlopeFeatureEnabled.load();
+    s.dwStartDeg = S::dwStartDeg.load();
+    s.dwFullDeg = S::dwFullDeg.load();
+    s.dwBuildUpPerSec = S::dwBuildUpPerSec.load();
+    s.dwDryPerSec = S::dwDryPerSec.load();
+    s.locationAffects = S::locationAffects;
+    s.locationMode = S::locationMode;
+    s.weatherEnabled = S::weatherEnabled.load();
+    s.weatherAffects = S::weatherAffects;
+    s.weatherMode = S::weatherMode;
+    s.weatherIgnoreInterior = S::weatherIgnoreInterior.load();
+
+    const auto rev = S::formRulesRevision.load();
+    if (prevRules && prevRules->revision == rev) {
+        s.rules = prevRules;
+    } else {
+        s.rules = std::make_shared<const Settings::FormRules>(
+            Settings::FormRules{S::reduceInLocationType, S::reduceInLocationSpecific, S::reduceInWeatherSpecific,
+                                S::beastRaces, rev});
+    }
+    return s;
+}
+
+std::recursive_mutex& Settings::WriteMutex() {
+    static std::recursive_mutex mx;
+    return mx;
+}
+
+static std::atomic<std::shared_ptr<const Settings::Snapshot>>& PublishedSnapshot() {
+    static std::atomic<std::shared_ptr<const Settings::Snapshot>> slot{[] {
+        const auto lk = Settings::LockWrites();
+        return std::make_shared<const Settings::Snapshot>(CaptureSnapshot(nullptr));
+    }()};
+    return slot;
+}
+
+std::shared_ptr<const Settings::Snapshot> Settings::Current() {
+    return PublishedSnapshot().load(std::memory_order_acquire);
+}
+
+bool Settings::Publish() {
+    const auto lk = LockWrites();  // no writer mid-edit while capturing, readers never lock
+
+    auto& slot = PublishedSnapshot();
+    const auto cur = slot.load(std::memory_order_acquire);
+    Snapshot next = CaptureSnapshot(cur->rules);
+    next.epoch = cur->epoch;
+    if (next == *cur) return false;
+
+    ++next.epoch;
+    slot.store(std::make_shared<const Snapshot>(std::move(next)), std::memory_order_release);
+    return true;
+}
@@ -1,11 +1,13 @@
 ﻿#include "SpeedController.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
 
+#include "Diagnostics.h"
+#include "MovementMath.h"
 #include "SKSE/Logger.h"
-#include "nlohmann/json.hpp"
-using nlohmann::json;
 
 using namespace RE;
 
@@ -137,11 +139,12 @@ SpeedController* SpeedController::GetSingleton() {
 }
 
 void SpeedController::Install() {
-    Settings::LoadFromJson(Settings::DefaultPath());
-    LoadToggleBindingFromJson();
-    lastApplyPlayerMs_ = NowMs();
+    ReloadSettings();
+    core_.SyncSettings();
+    rules_.Rebuild(*core_.Config().rules);
+    core_.Actors().lastApplyMs[ActorStateTable::kPlayerSlot] = NowMs();
 
-    prevAffectNPCs_ = Settings::enableSpeedScalingForNPCs.load();
+    prevAffectNPCs_ = core_.Config().enableSpeedScalingForNPCs;
 
     if (auto* holder = RE::ScriptEventSourceHolder::GetSingleton()) {
         holder->AddEventSink<RE::TESCombatEvent>(this);
@@ -157,195 +160,125 @@ void SpeedController::Install() {
 
     StartHeartbeat();
     Apply();
+    core_.FlushRefreshes(npcBuf_);
 }
 
-template <class T>
-static T* LookupForm(const std::string& plugin, std::uint32_t id) {
-    auto* dh = RE::TESDataHandler::GetSingleton();
-    if (!dh) return nullptr;
-    return dh->LookupForm<T>(id, plugin);
-}
-
-static RE::BGSLocation* GetPlayerLocation(const RE::PlayerCharacter* pc) {
-    if (!pc) return nullptr;
+static RE::BGSLocation* GetActorLocation(const RE::Actor* a) {
+    if (!a) return nullptr;
 
-    if (auto* loc = pc->GetCurrentLocation()) return loc;
+    if (auto* loc = a->GetCurrentLocation()) return loc;
 
-    if (auto* cell = pc->GetParentCell()) {
+    if (auto* cell = a->GetParentCell()) {
         if (auto* loc2 = cell->GetLocation()) return loc2;
     }
     return nullptr;
 }
 
-static std::optional<float> ComputeLocationValue(const RE::PlayerCharacter* pc) {
-    auto* loc = GetPlayerLocation(pc);
-    if (!loc) return std::nullopt;
-
-    for (auto& fs : Settings::reduceInLocationSpecific) {
-        if (auto* l = LookupForm<RE::BGSLocation>(fs.plugin, fs.id); l && l == loc) {
-            return fs.value;
-        }
-    }
-
-    if (auto* kwSet = loc->keywords) {
-        for (auto& fs : Settings::reduceInLocationType) {
-            if (auto* kw = LookupForm<RE::BGSKeyword>(fs.plugin, fs.id); kw) {
-                if (loc->HasKeyword(kw)) {
-                    return fs.value;
-                }
-            }
-        }
+static RE::TESWeather* GetCurrentWeather() {
+    if (auto* sky = RE::Sky::GetSingleton()) {
+        return sky->currentWeather;
     }
-    return std::nullopt;
+    return nullptr;
 }
 
-static bool RaceIs(const RE::Actor* a, std::string_view edid) {
-    if (!a) return false;
-    auto* r = a->GetRace();
-    if (!r) return false;
-    if (const char* id = r->GetFormEditorID()) {
-        return _stricmp(id, edid.data()) == 0;
+static RE::ActorValue ToActorValue(ActorStat av) {
+    switch (av) {
+        case ActorStat::SpeedMult:
+            return RE::ActorValue::kSpeedMult;
+        case ActorStat::WeaponSpeedMult:
+            return RE::ActorValue::kWeaponSpeedMult;
+        case ActorStat::Health:
+            return RE::ActorValue::kHealth;
+        case ActorStat::Stamina:
+            return RE::ActorValue::kStamina;
+        case ActorStat::Magicka:
+            return RE::ActorValue::kMagicka;
     }
-    return false;
+    return RE::ActorValue::kSpeedMult;
 }
 
-static bool TrySetAnyGraphVarFloat(RE::Actor* a, std::initializer_list<const char*> names, float v) {
-    bool any = false;
-    for (auto n : names) {
-        any |= a->SetGraphVariableFloat(n, v);
-    }
-    return any;
+Vec3 SpeedController::GetPosition(ActorRef a) const {
+    const auto p = AsActor(a)->GetPosition();
+    return Vec3{p.x, p.y, p.z};
 }
 
-static inline void ClampSpeedFloor(RE::Actor* a) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-    const float floor = Settings::minFinalSpeedMult.load();
-    const float cur = avo->GetActorValue(RE::ActorValue::kSpeedMult);
-    if (cur < floor) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, floor - cur);
+float SpeedController::GetScale(ActorRef a) const {
+    float s = 1.0f;
+    try {
+        s = AsActor(a)->GetScale();
+    } catch (...) {
     }
+    return s;
 }
 
-static RE::TESWeather* GetCurrentWeather() {
-    if (auto* sky = RE::Sky::GetSingleton()) {
-        return sky->currentWeather;
-    }
-    return nullptr;
+ActorPlace SpeedController::GetPlace(ActorRef a) const {
+    const auto* actor = AsActor(a);
+    const RE::TESObjectCELL* cell = actor->GetParentCell();
+    return ActorPlace{GetActorLocation(actor), cell, cell && cell->IsInteriorCell()};
 }
 
-static std::optional<float> ComputeWeatherValue(const RE::Actor* a) {
-    if (!Settings::weatherEnabled.load()) return std::nullopt;
-    if (Settings::weatherIgnoreInterior.load()) {
-        const RE::TESObjectCELL* cell = a ? a->GetParentCell() : nullptr;
-        if (cell && cell->IsInteriorCell()) return std::nullopt;
-    }
-    auto* cur = GetCurrentWeather();
-    if (!cur) return std::nullopt;
-    for (auto& fs : Settings::reduceInWeatherSpecific) {
-        if (auto* w = LookupForm<RE::TESWeather>(fs.plugin, fs.id); w && w == cur) {
-            return fs.value;
-        }
-    }
-    return std::nullopt;
+std::optional<float> SpeedController::GetLocationModifier(const ActorPlace& p) const {
+    return rules_.LocationValue(static_cast<const RE::BGSLocation*>(p.location));
 }
-static float LinearVitalPenaltyPct(const RE::Actor* a, RE::ActorValue av, bool enabled, float thrPct, float reducePct,
-                                   float smoothWidthPct) {
-    if (!enabled || !a) return 0.0f;
 
-    RE::Actor* ac = const_cast<RE::Actor*>(a);
-    auto* avo = ac ? ac->AsActorValueOwner() : nullptr;
-    if (!avo) return 0.0f;
+std::optional<float> SpeedController::GetWeatherModifier(const ActorPlace& p) const {
+    const auto& cfg = core_.Config();
+    if (!cfg.weatherEnabled) return std::nullopt;
+    if (cfg.weatherIgnoreInterior && p.interior) return std::nullopt;
+    return rules_.WeatherValue(GetCurrentWeather());
+}
 
-    const float cur = avo->GetActorValue(av);
+float SpeedController::GetActorValue(ActorRef a, ActorStat av) const {
+    auto* avo = AsActor(a)->AsActorValueOwner();
+    return avo ? avo->GetActorValue(ToActorValue(av)) : 0.0f;
+}
 
-    float maxv = 0.0f;
+float SpeedController::GetPermanentActorValue(ActorRef a, ActorStat av) const {
+    auto* avo = AsActor(a)->AsActorValueOwner();
+    if (!avo) return 0.0f;
+    float v = 0.0f;
     try {
-        maxv = avo->GetPermanentActorValue(av);
+        v = avo->GetPermanentActorValue(ToActorValue(av));
     } catch (...) {
     }
-    if (maxv <= 1e-3f) return 0.0f;
-
-    const float pct = std::clamp(cur / maxv * 100.0f, 0.0f, 100.0f);
-    const float w = std::max(0.0f, smoothWidthPct);
-
-    float factor = 0.0f;
-    if (pct <= thrPct - w)
-        factor = 1.0f;
-    else if (pct < thrPct && w > 0.f)
-        factor = (thrPct - pct) / w;
-    else
-        factor = 0.0f;
-
-    return -reducePct * std::clamp(factor, 0.0f, 1.0f);
+    return v;
 }
 
-namespace {
-    inline bool IsWithinNPCProcRadius(const RE::Actor* a) {
-        if (!a) return false;
-        auto* pc = RE::PlayerCharacter::GetSingleton();
-        if (!pc) return false;
-        if (a == pc) return true;
-
-        const int r = Settings::npcRadius.load();
-        if (r <= 0) return true;
-
-        const auto ap = a->GetPosition();
-        const auto pp = pc->GetPosition();
-        const float dx = ap.x - pp.x;
-        const float dy = ap.y - pp.y;
-        const float r2 = static_cast<float>(r) * static_cast<float>(r);
-        return (dx * dx + dy * dy) <= r2;  // XY-Radius
-    }
-    inline float ExpoLerp(float prev, float target, float dt, float tau) {
-        if (tau <= 1e-6f) return target;
-        const float a = 1.0f - std::exp(-dt / std::max(1e-4f, tau));
-        return prev + a * (target - prev);
-    }
-    inline float RateTowards(float prev, float target, float dt, float ratePerSec) {
-        if (ratePerSec <= 0.f) return target;
-        const float maxStep = ratePerSec * dt;
-        const float d = target - prev;
-        if (d > maxStep) return prev + maxStep;
-        if (d < -maxStep) return prev - maxStep;
-        return target;
-    }
-    inline float SmoothSprintAnim(float prev, float target, float dt) {
-        if (!Settings::sprintAnimOwnSmoothing.load()) {
-            return prev + (target - prev);
-        }
-        using SM = Settings::SmoothingMode;
-        const auto mode = static_cast<SM>(Settings::sprintAnimSmoothingMode.load());
-        switch (mode) {
-            case SM::RateLimit:
-                return RateTowards(prev, target, dt, Settings::sprintAnimRatePerSec.load());
-            case SM::ExpoThenRate:
-                return RateTowards(prev, ExpoLerp(prev, target, dt, Settings::sprintAnimTau.load()), dt,
-                                   Settings::sprintAnimRatePerSec.load());
-            case SM::Exponential:
-            default:
-                return ExpoLerp(prev, target, dt, Settings::sprintAnimTau.load());
-        }
+void SpeedController::ModActorValue(ActorRef a, ActorStat av, float delta) {
+    DSC_COUNT(Diag::Counter::AvWrites, 1);
+    if (auto* avo = AsActor(a)->AsActorValueOwner()) {
+        avo->ModActorValue(ToActorValue(av), delta);
     }
-    inline float PredictDiagonalPenalty(float curSM, float floor, float inX, float inY, bool sprinting) {
-        // f = max(|x|,|y|)/sqrt(x^2+y^2) (<=1)
-        const float ax = std::fabs(inX), ay = std::fabs(inY);
-        const float mag = std::sqrt(inX * inX + inY * inY);
-        const float maxc = std::max(ax, ay);
-        if (mag <= 1e-4f || maxc <= 0.0f) return 0.0f;
-
-        float f = std::min(1.0f, maxc / mag);
-        float headroom = std::max(0.0f, curSM - floor);
-        float penalty = headroom * (f - 1.0f);
-        if (sprinting) penalty *= 0.5f;
-        return penalty;
+}
+
+bool SpeedController::IsWorldWet(RE::Actor* a) {
+    const void* cell = a->GetParentCell();
+    const void* weather = GetCurrentWeather();
+    const uint64_t nowMs = NowMs();
+    auto& c = wetEnv_;
+    if (!c.valid || c.cell != cell || c.weather != weather || nowMs - c.queriedMs >= kWetEnvMaxAgeMs) {
+        c.wet = SWE_Link::IsWorldWet(a);
+        c.cell = cell;
+        c.weather = weather;
+        c.queriedMs = nowMs;
+        c.valid = true;
     }
+    return c.wet;
+}
 
+void SpeedController::PublishSweat(ActorRef ref, float intensity) {
+    // The core only calls this on a change or before the hold runs out
+    auto* a = AsActor(ref);
+    constexpr float kHoldSec = 1.75f;
+    SWE_Link::SetSweat(a, intensity, kHoldSec, IsWorldWet(a));
 }
-void SpeedController::UpdateSprintAnimRate(RE::Actor* a) {
-    if (!a) return;
-    if (!Settings::syncSprintAnimToSpeed.load()) return;
+
+void SpeedController::ClearSweat(ActorRef a) { SWE_Link::ClearSweat(AsActor(a)); }
+
+bool SpeedController::UpdateSprintAnimRate(RE::Actor* a) {
+    if (!a) return false;
+    const auto& cfg = core_.Config();
+    if (!cfg.syncSprintAnimToSpeed) return false;
 
     bool sprinting = IsSprintingByGraph(a);
     if (!sprinting) {
@@ -357,13 +290,13 @@ void SpeedController::UpdateSprintAnimRate(RE::Actor* a) {
     }
 
     auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
+    if (!avo) return false;
 
     float target = 1.0f;
     if (sprinting) {
         float ratio = std::max(1.0f, avo->GetActorValue(RE::ActorValue::kSpeedMult)) / 100.0f;
-        if (Settings::onlySlowDown.load()) ratio = std::min(ratio, 1.0f);
-        target = std::clamp(ratio, Settings::sprintAnimMin.load(), Settings::sprintAnimMax.load());
+        if (cfg.onlySlowDown) ratio = std::min(ratio, 1.0f);
+        target = std::clamp(ratio, cfg.sprintAnimMin, cfg.sprintAnimMax);
     }
 
     const uint64_t nowMs = NowMs();
@@ -371,9 +304,11 @@ void SpeedController::UpdateSprintAnimRate(RE::Actor* a) {
     const float dt = (lastMs == 0) ? (1.0f / 60.0f) : std::max(0.0f, (nowMs - lastMs) / 1000.0f);
     lastMs = nowMs;
 
-    sprintAnimRate_ = SmoothSprintAnim(sprintAnimRate_, target, dt);
+    sprintFilter_.SyncSprintAnim(cfg);
+    sprintAnimRate_ = sprintFilter_.Step(sprintAnimRate_, target, dt);
 
-    TrySetAnyGraphVarFloat(a, {"fAnimSpeedMult", "AnimSpeedMult", "AnimSpeed", "fSprintSpeedMult"}, sprintAnimRate_);
+    graphVars_.SetAnimSpeed(a, sprintAnimRate_);
+    return std::fabs(sprintAnimRate_ - target) > 1e-3f;
 }
 
 RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::TESEquipEvent* evn,
@@ -384,161 +319,27 @@ RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::TESEquipEvent*
     RE::Actor* a = ref ? ref->As<RE::Actor>() : nullptr;
     if (!a) return RE::BSEventNotifyControl::kContinue;
 
+    // Armor and weapon weight are read on the next heartbeat, not here
     auto* pc = RE::PlayerCharacter::GetSingleton();
     if (a == pc) {
-        UpdateAttackSpeed(a);
-    } else if (Settings::enableSpeedScalingForNPCs.load()) {
-        if (IsWithinNPCProcRadius(a)) {
-            UpdateAttackSpeed(a);
+        core_.MarkEquipChanged(Ref(a));
+        WakeHeartbeat();
+    } else if (core_.Config().enableSpeedScalingForNPCs) {
+        if (core_.IsWithinNPCProcRadius(Ref(a))) {
+            core_.MarkEquipChanged(Ref(a));
         } else {
-            RevertDeltasFor(a);
-            ClearNPCState(GetID(a));
+            core_.RevertDeltasFor(Ref(a));
+            core_.ClearNPCState(GetID(a));
+            core_.FlushRefreshes();
         }
     }
     return RE::BSEventNotifyControl::kContinue;
 }
 
-float& SpeedController::SlopeDeltaSlot(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return slopeDeltaPlayer_;
-    return slopeDeltaNPC_[GetID(a)];
-}
-
-void SpeedController::ClearSlopeDeltaFor(RE::Actor* a) {
-    float& slot = SlopeDeltaSlot(a);
-    if (std::fabs(slot) > 1e-4f) {
-        if (auto* avo = a->AsActorValueOwner()) {
-            avo->ModActorValue(RE::ActorValue::kSpeedMult, -slot);
-        }
-        slot = 0.0f;
-    }
-    SlopeResidualSlot(a) = 0.0f;
-
-    ClearPathFor(a);
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) {
-        lastSlopePlayerMs_ = 0;
-    } else {
-        lastSlopeNPCMs_.erase(GetID(a));
-    }
-}
-
-bool SpeedController::UpdateSlopePenalty(RE::Actor* a, float dt) {
-    if (!a || dt <= 0.f) return false;
-    if (!Settings::slopeEnabled.load()) return false;
-    if (a != RE::PlayerCharacter::GetSingleton() && !Settings::slopeAffectsNPCs.load()) return false;
-
-    const uint64_t nowMs = NowMs();
-    const auto pos = a->GetPosition();
-
-    PushPathSample(a, pos, nowMs);
-
-    float slopeDeg = 0.0f;
-    bool haveSlope = false;
-
-    bool still = false;
-
-    auto& q = PathBuf(a);
-    if (q.size() >= 2) {
-        const float movedXY = q.back().sxy - q[q.size() - 2].sxy;
-        still = (std::fabs(movedXY) < Settings::slopeMinXYPerFrame.load());
-    }
-
-    if (Settings::slopeMethod.load() == 1) {
-        haveSlope =
-            ComputePathSlopeDeg(a, Settings::slopeLookbackUnits.load(), Settings::slopeMaxHistorySec.load(), slopeDeg);
-        if (a == RE::PlayerCharacter::GetSingleton() 
-            && Settings::dwEnabled.load() 
-            && Settings::dwSlopeFeatureEnabled.load()) {
-            static float s_dwIntensity = 0.0f;
-
-            const float startDeg = std::max(0.0f, Settings::dwStartDeg.load());
-            const float fullDeg = std::max(startDeg + 0.1f, Settings::dwFullDeg.load());
-            const float span = std::max(0.1f, fullDeg - startDeg);
-
-            float target = 0.0f;
-
-            if (!still && haveSlope && slopeDeg > startDeg) {
-                const float moveMag = std::clamp(std::sqrt(moveX_ * moveX_ + moveY_ * moveY_), 0.0f, 1.0f);
-                const float slopePart = std::clamp((slopeDeg - startDeg) / span, 0.0f, 1.0f);
-                target = std::clamp(slopePart * (0.50f + 0.50f * moveMag), 0.0f, 1.0f);
-            }
-
-            const float rateUp = std::max(0.0f, Settings::dwBuildUpPerSec.load());
-            const float rateDown = std::max(0.0f, Settings::dwDryPerSec.load());
-            const float rate = (target >= s_dwIntensity) ? rateUp : rateDown;
-
-            s_dwIntensity = RateTowards(s_dwIntensity, target, dt, rate);
-
-            static float s_lastSent = -1.0f;
-            static uint64_t s_lastMs = 0;
-            const uint64_t nowMs = NowMs();
-
-            const bool wetEnv = SWE_Link::IsWorldWet(a);
-            constexpr float kHoldSec = 1.75f;
-            constexpr float kEps = 1e-3f;
-
-            float sendVal = (s_dwIntensity > kEps) ? s_dwIntensity : 0.0f;
-            bool needSend = std::fabs(sendVal - s_lastSent) > 0.01f ||
-                            (sendVal == 0.0f && (nowMs - s_lastMs) > 600);  // TTL
-
-            if (needSend) {
-                SWE_Link::SetSweat(a, sendVal, kHoldSec, wetEnv);
-                s_lastSent = sendVal;
-                s_lastMs = nowMs;
-            }
-        } else {
-            SWE_Link::ClearSweat(a);
-        }
-    } else {
-        haveSlope = false;
-    }
-
-    float want = 0.0f;
-    if (Settings::slopeMethod.load() == 1) {
-        if (!still) {
-            bool haveSlope = ComputePathSlopeDeg(a, Settings::slopeLookbackUnits.load(),
-                                                 Settings::slopeMaxHistorySec.load(), slopeDeg);
-            if (haveSlope) {
-                if (slopeDeg > 0.0f)
-                    want -= Settings::slopeUphillPerDeg.load() * slopeDeg;
-                else if (slopeDeg < 0.0f)
-                    want += Settings::slopeDownhillPerDeg.load() * (-slopeDeg);
-                want = std::clamp(want, -Settings::slopeMaxAbs.load(), Settings::slopeMaxAbs.load());
-            }
-        } else {
-            want = 0.0f;
-        }
-    } else {
-        want = 0.0f;
-    }
-
-    float& slot = SlopeDeltaSlot(a);
-    const float tau = std::max(0.01f, Settings::slopeTau.load());
-    const float alpha = 1.0f - std::exp(-dt / tau);
-    const float newDelta = slot + alpha * (want - slot);
-
-    float diff = newDelta - slot;
-    float& acc = SlopeResidualSlot(a);
-    acc += diff;
-
-    static constexpr float kSlopeGran = 1e-4f;
-    if (std::fabs(acc) >= kSlopeGran) {
-        if (auto* avo = a->AsActorValueOwner()) {
-            avo->ModActorValue(RE::ActorValue::kSpeedMult, acc);
-            slot += acc;
-            acc = 0.0f;
-            return true;
-        }
-    }
-    return false;
-}
-
 RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::TESLoadGameEvent*,
                                                        RE::BSTEventSource<RE::TESLoadGameEvent>*) {
     loading_.store(true, std::memory_order_relaxed);
-    Settings::LoadFromJson(Settings::DefaultPath());
-    LoadToggleBindingFromJson();
+    ReloadSettings();
     lastSprintMs_.store(0, std::memory_order_relaxed);
 
     // OnPostLoadGame();
@@ -548,7 +349,11 @@ RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::TESLoadGameEven
 RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::TESCombatEvent* evn,
                                                        RE::BSTEventSource<RE::TESCombatEvent>*) {
     if (evn) {
+        for (RE::TESObjectREFR* ref : {evn->actor.get(), evn->targetActor.get()}) {
+            if (auto* a = ref ? ref->As<RE::Actor>() : nullptr) core_.MarkDirty(Ref(a), SpeedCore::kDirtyState);
+        }
         pendingRefresh_.store(true, std::memory_order_relaxed);
+        WakeHeartbeat();
     }
     return RE::BSEventNotifyControl::kContinue;
 }
@@ -568,6 +373,7 @@ RE::BSEventNotifyControl SpeedController::ProcessEvent(const RE::BSAnimationGrap
     }*/
 
     pendingRefresh_.store(true, std::memory_order_relaxed);
+    WakeHeartbeat();
     return RE::BSEventNotifyControl::kContinue;
 }
 
@@ -577,74 +383,70 @@ RE::BSEventNotifyControl SpeedController::ProcessEvent(RE::InputEvent* const* ev
         return RE::BSEventNotifyControl::kContinue;
     }
 
+    // Only the latest raw axes are kept here, the heartbeat shapes them and runs the diagonal fix once per tick
     bool axisChanged = false;
 
     auto setAxis = [&](float& axis, float newVal) {
-        if (std::fabs(axis - newVal) > 1e-3f) {
+        if (axis != newVal) {
             axis = newVal;
             axisChanged = true;
         }
     };
 
+    float& moveX = rawMoveX_;
+    float& moveY = rawMoveY_;
+
+    const auto map = actionMap_.load(std::memory_order_acquire);
+    if (map.get() != heldKeysMap_) {
+        heldKeys_ = 0;
+        heldKeysMap_ = map.get();
+    }
+
     for (auto e = *evns; e; e = e->next) {
         // --- Button-Events (Keyboard/Buttons) ---
         if (e->eventType == RE::INPUT_EVENT_TYPE::kButton) {
             auto* be = static_cast<RE::ButtonEvent*>(e);
             const bool isDown = (be->value > 0.0f);
             const bool isPress = isDown && (be->heldDownSecs == 0.0f);
-            const RE::BSFixedString evName = be->userEvent;
+            const auto actions = map->ForEvent(be->userEvent);
+            const auto keyActions = map->ForKey(be->idCode, isDown, isPress, heldKeys_);
 
-            if (!sprintUserEvent_.empty() && evName == RE::BSFixedString(sprintUserEvent_.c_str())) {
+            if (actions & InputActionMap::kSprint) {
                 if (be->value > 0.0f) {
                     lastSprintMs_.store(NowMs(), std::memory_order_relaxed);
+                    WakeHeartbeat();
                 } else {
                     lastSprintMs_.store(0, std::memory_order_relaxed);
                 }
             }
 
-            if (evName == "Forward") {
-                setAxis(moveY_, isDown ? +1.0f : (moveY_ > 0.0f ? 0.0f : moveY_));
-            } else if (evName == "Back") {
-                setAxis(moveY_, isDown ? -1.0f : (moveY_ < 0.0f ? 0.0f : moveY_));
-            } else if (evName == "Strafe Left" || evName == "StrafeLeft" || evName == "MoveLeft") {
-                setAxis(moveX_, isDown ? -1.0f : (moveX_ < 0.0f ? 0.0f : moveX_));
-            } else if (evName == "Strafe Right" || evName == "StrafeRight" || evName == "MoveRight") {
-                setAxis(moveX_, isDown ? +1.0f : (moveX_ > 0.0f ? 0.0f : moveX_));
+            if (actions & InputActionMap::kForward) {
+                setAxis(moveY, isDown ? +1.0f : (moveY > 0.0f ? 0.0f : moveY));
+            } else if (actions & InputActionMap::kBack) {
+                setAxis(moveY, isDown ? -1.0f : (moveY < 0.0f ? 0.0f : moveY));
+            } else if (actions & InputActionMap::kStrafeLeft) {
+                setAxis(moveX, isDown ? -1.0f : (moveX < 0.0f ? 0.0f : moveX));
+            } else if (actions & InputActionMap::kStrafeRight) {
+                setAxis(moveX, isDown ? +1.0f : (moveX > 0.0f ? 0.0f : moveX));
             }
 
             if (loading_.load(std::memory_order_relaxed)) {
                 continue;
             }
 
-            // Jogging-Toggle
-            bool matched = false;
-            if (!toggleUserEvent_.empty() && evName == RE::BSFixedString(toggleUserEvent_.c_str())) {
-                matched = isPress;
-            }
-            if (!matched && toggleKeyCode_ != 0 && isPress && be->idCode == toggleKeyCode_) {
-                matched = true;
-            }
+            // Jogging-Toggle: user event on press, or a key / chord completed by this press
+            const bool matched = (isPress && (actions & InputActionMap::kToggleJogging)) ||
+                                 (keyActions & InputActionMap::kToggleJogging);
 
             if (matched) {
                 const auto now = std::chrono::steady_clock::now();
                 if (now - lastToggle_ >= toggleCooldown_) {
                     if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
-                        ClearDiagDeltaFor(pc);
-
-                        const float before = CaseToDelta(pc);
-                        joggingMode_ = !joggingMode_;
-                        const float after = CaseToDelta(pc);
-                        const float diff = after - before;
-
-                        if (std::fabs(diff) > 0.01f) {
-                            ModSpeedMult(pc, diff);
-                        }
-                        currentDelta = after;
-
-                        if (Settings::enableDiagonalSpeedFix.load()) {
-                            UpdateDiagonalPenalty(pc);
-                        }
-                        ForceSpeedRefresh(pc);
+                        FlushInput();
+                        core_.SetPlayer(Ref(pc));
+                        core_.ToggleJogging();
+                        core_.FlushRefreshes();
+                        WakeHeartbeat();
                     }
                     lastToggle_ = now;
                 }
@@ -656,54 +458,31 @@ RE::BSEventNotifyControl SpeedController::ProcessEvent(RE::InputEvent* const* ev
             auto* te = static_cast<RE::ThumbstickEvent*>(e);
 
             if (te) {
-                float nx = te->xValue;
-                float ny = te->yValue;
-
-                // Deadzone
-                const float dead = 0.12f;
-                if (std::fabs(nx) < dead) nx = 0.f;
-                if (std::fabs(ny) < dead) ny = 0.f;
-
-                setAxis(moveX_, nx);
-                setAxis(moveY_, ny);
+                setAxis(moveX, te->xValue);
+                setAxis(moveY, te->yValue);
             }
         }
     }
 
     if (axisChanged) {
-        if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
-            if (Settings::enableDiagonalSpeedFix.load()) {
-                if (UpdateDiagonalPenalty(pc)) {
-                    pendingRefresh_.store(true, std::memory_order_relaxed);
-                }
-            } else {
-                ClearDiagDeltaFor(pc);
-            }
-        }
+        inputDirty_ = true;
+        WakeHeartbeat();
     }
 
     return RE::BSEventNotifyControl::kContinue;
 }
 
-void SpeedController::ClearNPCState(std::uint32_t id) {
-    smVelNPC_.erase(id);
-    wantFilteredNPC_.erase(id);
-    lastApplyNPCMs_.erase(id);
-    lastSlopeNPCMs_.erase(id);
-    prevNPCSprinting_.erase(id);
-    prevNPCSneak_.erase(id);
-    prevNPCDrawn_.erase(id);
-    slopeDeltaNPC_.erase(id);
-    lastPosNPC_.erase(id);
-    groundDeltaNPC_.erase(id);
-    currentDeltaNPC_.erase(id);
-    attackDeltaNPC_.erase(id);
-    diagDeltaNPC_.erase(id);
-    diagResidualNPC_.erase(id);
-    slopeResidualNPC_.erase(id);
-    scaleResidualNPC_.erase(id);
-    scaleDeltaNPC_.erase(id);
-    pathNPC_.erase(id);
+void SpeedController::FlushInput() {
+    if (!inputDirty_) return;
+    inputDirty_ = false;
+
+    const auto& cfg = core_.Config();
+    float x = rawMoveX_, y = rawMoveY_;
+    MovementMath::ShapeStickInput(x, y, cfg.inputDeadzone, cfg.inputRadialDeadzone, cfg.inputAxisStep);
+
+    // Sub-threshold jitter keeps the previous axes, so the tick sees no change at all
+    if (std::fabs(core_.moveX - x) > 1e-3f) core_.moveX = x;
+    if (std::fabs(core_.moveY - y) > 1e-3f) core_.moveY = y;
 }
 
 float SpeedController::ComputeEquippedWeight(const RE::Actor* a) const {
@@ -725,92 +504,42 @@ float SpeedController::ComputeEquippedWeight(const RE::Actor* a) const {
     return 0.0f;
 }
 
-float SpeedController::GetPlayerScaleSafe(const RE::Actor* a) const {
-    if (!a) return 1.0f;
-    float s = 1.0f;
-    try {
-        s = a->GetScale();
-    } catch (...) {
+void SpeedController::PublishActionMap() {
+    InputActionMap::Config c;
+    {
+        const auto lk = Settings::LockWrites();  // the strings are edited by the menu, loaded on the game thread
+        c.sprintEvents = Settings::sprintEventName;
+        c.toggleEvents = Settings::toggleSpeedEvent;
+        c.toggleKey = static_cast<std::uint32_t>(std::max(0, Settings::toggleSpeedKey.load()));
+        c.toggleChords = Settings::toggleSpeedChords;
     }
-    if (s <= 0.01f || s > 10.0f) s = 1.0f;
-    return s;
+    actionMap_.store(std::make_shared<const InputActionMap>(InputActionMap::Build(c)), std::memory_order_release);
 }
 
-void SpeedController::UpdateAttackSpeed(RE::Actor* actor) {
-    if (!actor) return;
-
-    float& myDelta = AttackDeltaSlot(actor);
-
-    if (std::fabs(myDelta) > 1e-6f) {
-        if (auto* avo = actor->AsActorValueOwner()) {
-            avo->ModActorValue(RE::ActorValue::kWeaponSpeedMult, -myDelta);
-        }
-        myDelta = 0.0f;
-    }
-
-    if (Settings::ignoreBeastForms.load() && IsInBeastForm(actor)) return;
-    if (!Settings::attackSpeedEnabled) return;
-    if (Settings::attackOnlyWhenDrawn && !IsWeaponDrawnByState(actor)) return;
-
-    const float w = ComputeEquippedWeight(actor);
-    const float scale = Settings::usePlayerScale ? GetPlayerScaleSafe(actor) : 1.0f;
-
-    float target = Settings::attackBase + Settings::weightSlope * (w - Settings::weightPivot) +
-                   (Settings::usePlayerScale ? (Settings::scaleSlope * (scale - 1.0f)) : 0.0f);
+void SpeedController::ReloadSettings() {
+    const auto path = Settings::DefaultPath();
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto r = Settings::LoadFromJsonIfChanged(path);
+    PublishActionMap();  // the statics were re-applied even when unchanged, and it is the first build without a file
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0);
 
-    target = std::max(Settings::minAttackMult.load(), std::min(Settings::maxAttackMult.load(), target));
-
-    if (Settings::armorAffectsAttackSpeed.load()) {
-        const float aw = ComputeArmorWeight(actor);
-        target += Settings::armorWeightSlopeAtk.load() * (aw - Settings::armorWeightPivot.load());
-    }
-
-    auto* avo = actor->AsActorValueOwner();
-    if (!avo) return;
-
-    const float cur = avo->GetActorValue(RE::ActorValue::kWeaponSpeedMult);
-    const float delta = target - cur;
-
-    if (std::fabs(delta) > 1e-4f) {
-        avo->ModActorValue(RE::ActorValue::kWeaponSpeedMult, delta);
-        myDelta = delta;
+    switch (r) {
+        case Settings::LoadResult::Loaded:
+            spdlog::info("[Settings] loaded {} in {} us", path.string(), us.count());
+            break;
+        case Settings::LoadResult::Unchanged:
+            spdlog::info("[Settings] {} unchanged, re-applied without parsing ({} us)", path.string(), us.count());
+            break;
+        case Settings::LoadResult::Failed:
+            spdlog::warn("[Settings] could not load {}, keeping the current values ({} us)", path.string(),
+                         us.count());
+            break;
     }
 }
 
 void SpeedController::UpdateBindingsFromSettings() {
-    toggleKeyCode_ = Settings::toggleSpeedKey.load();
-    toggleUserEvent_ = Settings::toggleSpeedEvent;
-    sprintUserEvent_ = Settings::sprintEventName;
-
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (pc) {
-        this->Apply();
-        this->ForceSpeedRefresh(pc);
-    }
-}
-
-void SpeedController::LoadToggleBindingFromJson() {
-    toggleKeyCode_ = 0;
-    toggleUserEvent_.clear();
-    sprintUserEvent_ = Settings::sprintEventName;
-
-    std::ifstream in(Settings::DefaultPath());
-    if (!in.is_open()) return;
-    try {
-        nlohmann::json j;
-        in >> j;
-
-        if (j.contains("kToggleSpeedKey") && j["kToggleSpeedKey"].is_number_integer()) {
-            toggleKeyCode_ = static_cast<uint32_t>(j["kToggleSpeedKey"].get<int>());
-        }
-        if (j.contains("kToggleSpeedEvent") && j["kToggleSpeedEvent"].is_string()) {
-            toggleUserEvent_ = j["kToggleSpeedEvent"].get<std::string>();
-        }
-        if (j.contains("kSprintEventName") && j["kSprintEventName"].is_string()) {
-            sprintUserEvent_ = j["kSprintEventName"].get<std::string>();
-        }
-    } catch (...) {
-    }
+    PublishActionMap();
+    RefreshNow();
 }
 
 void SpeedController::StartHeartbeat() {
@@ -822,47 +551,61 @@ void SpeedController::StartHeartbeat() {
         using namespace std::chrono_literals;
         bool prevSprint = false;
         while (run_) {
-            std::this_thread::sleep_for(33ms);
+            {
+                std::unique_lock lk(wakeMx_);
+                const auto delay = std::chrono::milliseconds(nextBeatMs_.load(std::memory_order_relaxed));
+                wakeCv_.wait_for(lk, delay, [this] { return wake_ || !run_; });
+                wake_ = false;
+            }
             SKSE::GetTaskInterface()->AddTask([this, &prevSprint]() {
                 // Bail out completely while loading to avoid races and stale writes
                 if (loading_.load(std::memory_order_relaxed)) {
                     return;
                 }
 
+                this->FlushInput();
                 this->Apply();
 
                 if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
-                    this->UpdateAttackSpeed(pc);
-                    this->UpdateSprintAnimRate(pc);
+                    core_.UpdateAttackSpeed(Ref(pc));  // writes only when weapon, armor, scale, draw or settings moved
+                    const bool animBusy = this->UpdateSprintAnimRate(pc);
 
                     int n = postLoadNudges_.load(std::memory_order_relaxed);
                     if (n > 0) {
                         const uint64_t now = NowMs();
                         if (now >= postLoadGraceUntilMs_.load(std::memory_order_relaxed)) {
-                            ForceSpeedRefresh(pc);
+                            core_.QueueRefresh(Ref(pc));
                             postLoadNudges_.store(n - 1, std::memory_order_relaxed);
                         }
                     }
 
-                    if (pendingRefresh_.load(std::memory_order_relaxed)) {
-                        if (this->ForceSpeedRefresh(pc)) {
-                            pendingRefresh_.store(false, std::memory_order_relaxed);
-                        }
+                    // Set again by ForceSpeedRefresh while the post-load grace lasts
+                    if (pendingRefresh_.exchange(false, std::memory_order_relaxed)) {
+                        core_.QueueRefresh(Ref(pc));
                     }
 
                     const bool curSprint = IsSprintingLatched(pc);
                     if (curSprint != prevSprint) {
                         if (!curSprint) {
-                            pc->SetGraphVariableFloat("fAnimSpeedMult", 1.0f);
-                            pc->SetGraphVariableFloat("AnimSpeedMult", 1.0f);
-                            pc->SetGraphVariableFloat("AnimSpeed", 1.0f);
-                            pc->SetGraphVariableFloat("fSprintSpeedMult", 1.0f);
+                            graphVars_.SetAnimSpeed(pc, 1.0f);
                             sprintAnimRate_ = 1.0f;
                         }
-                        ClearDiagDeltaFor(pc);
-                        ForceSpeedRefresh(pc);
+                        core_.ClearDiagDeltaFor(Ref(pc));
+                        core_.QueueRefresh(Ref(pc));
                         prevSprint = curSprint;
                     }
+
+                    // One refresh per actor for everything the tick and the steps above asked for
+                    core_.FlushRefreshes(npcBuf_);
+                    core_.PublishStats();
+
+                    HeartbeatScheduler::Work w;
+                    w.coreActive = core_.ConsumeActivity();
+                    w.pendingRefresh = pendingRefresh_.load(std::memory_order_relaxed);
+                    w.postLoadNudges = postLoadNudges_.load(std::memory_order_relaxed) > 0;
+                    w.sprintAnim = animBusy || curSprint;
+                    nextBeatMs_.store(scheduler_.Next(w, core_.Config().heartbeatIdleMs),
+                                      std::memory_order_relaxed);
                 }
             });
         }
@@ -870,118 +613,17 @@ void SpeedController::StartHeartbeat() {
     th_.detach();
 }
 
-void SpeedController::ForEachTargetActor(const std::function<void(RE::Actor*)>& fn) {
-    if (!Settings::enableSpeedScalingForNPCs.load()) return;
-
-    auto* pl = RE::ProcessLists::GetSingleton();
-    if (!pl) return;
-
-    for (auto& h : pl->highActorHandles) {
-        RE::Actor* a = h.get().get();
-        if (!a) continue;
-        fn(a);
-    }
-}
-
-void SpeedController::RevertAllNPCDeltas() {
-    auto* pl = RE::ProcessLists::GetSingleton();
-    if (!pl) {
-        currentDeltaNPC_.clear();
-        attackDeltaNPC_.clear();
-        diagDeltaNPC_.clear();
-
-        diagResidualNPC_.clear();
-        slopeResidualNPC_.clear();
-        diagResidualPlayer_ = 0.0f;
-        slopeResidualPlayer_ = 0.0f;
+void SpeedController::WakeHeartbeat() {
+    // Only worth a notify when the heartbeat is on the idle cadence
+    if (nextBeatMs_.exchange(HeartbeatScheduler::kActiveMs, std::memory_order_relaxed) <=
+        HeartbeatScheduler::kActiveMs) {
         return;
     }
-
-    for (auto& h : pl->highActorHandles) {
-        RE::Actor* a = h.get().get();
-        if (!a) continue;
-
-        const auto id = GetID(a);
-        auto* avo = a->AsActorValueOwner();
-        if (!avo) continue;
-
-        if (auto it = currentDeltaNPC_.find(id); it != currentDeltaNPC_.end()) {
-            if (std::fabs(it->second) > 0.001f) {
-                avo->ModActorValue(RE::ActorValue::kSpeedMult, -it->second);
-                it->second = 0.0f;
-            }
-        }
-
-        if (auto jt = attackDeltaNPC_.find(id); jt != attackDeltaNPC_.end()) {
-            if (std::fabs(jt->second) > 1e-6f) {
-                avo->ModActorValue(RE::ActorValue::kWeaponSpeedMult, -jt->second);
-                jt->second = 0.0f;
-            }
-        }
-
-        if (auto dt = diagDeltaNPC_.find(id); dt != diagDeltaNPC_.end()) {
-            if (std::fabs(dt->second) > 0.001f) {
-                avo->ModActorValue(RE::ActorValue::kSpeedMult, -dt->second);
-                dt->second = 0.0f;
-            }
-        }
-
-        if (auto st = scaleDeltaNPC_.find(id); st != scaleDeltaNPC_.end()) {
-            if (std::fabs(st->second) > 0.001f) {
-                avo->ModActorValue(RE::ActorValue::kSpeedMult, -st->second);
-                st->second = 0.0f;
-            }
-        }
-
-        ClearSlopeDeltaFor(a);
-        ForceSpeedRefresh(a);
-    }
-
-    slopeDeltaNPC_.clear();
-    lastPosNPC_.clear();
-    currentDeltaNPC_.clear();
-    attackDeltaNPC_.clear();
-    diagDeltaNPC_.clear();
-    scaleResidualNPC_.clear();
-    scaleDeltaNPC_.clear();
-
-    diagResidualNPC_.clear();
-    slopeResidualNPC_.clear();
-    diagResidualPlayer_ = 0.0f;
-    slopeResidualPlayer_ = 0.0f;
-}
-
-float& SpeedController::AttackDeltaSlot(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return attackDelta_;
-    return attackDeltaNPC_[GetID(a)];
-}
-
-float& SpeedController::CurrentDeltaSlot(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return currentDelta;
-    return currentDeltaNPC_[GetID(a)];
-}
-
-void SpeedController::TryInitDrawnFromGraph() {
-    if (initTried_) return;
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    (void)pc;
-    initTried_ = true;
-}
-
-SpeedController::MoveCase SpeedController::ComputeCase(const RE::Actor* a) const {
-    if (!a) return MoveCase::Default;
-    if (Settings::noReductionInCombat && a->IsInCombat()) {
-        return MoveCase::Combat;
-    }
-    if (a->IsSneaking()) {
-        return MoveCase::Sneak;
-    }
-    if (IsWeaponDrawnByState(a)) {
-        return MoveCase::Drawn;
+    {
+        std::lock_guard lk(wakeMx_);
+        wake_ = true;
     }
-    return MoveCase::Default;
+    wakeCv_.notify_one();
 }
 
 void SpeedController::OnPreLoadGame() {
@@ -989,7 +631,10 @@ void SpeedController::OnPreLoadGame() {
     postLoadCleaned_.store(false, std::memory_order_relaxed);
     if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
         SWE_Link::ClearSweat(pc);
+        core_.Actors().sweat[ActorStateTable::kPlayerSlot] = SweatState{};
     }
+    wetEnv_ = {};
+    graphVars_.Clear();
 }
 
 void SpeedController::OnPostLoadGame() { DoPostLoadCleanup(); }
@@ -1003,15 +648,22 @@ void SpeedController::DoPostLoadCleanup() {
 
         loading_.store(true, std::memory_order_relaxed);
 
+        constexpr auto p = ActorStateTable::kPlayerSlot;
+        auto& actors = core_.Actors();
+
         if (pc && avo) {
+            const ActorRef pr = Ref(pc);
+            core_.SetPlayer(pr);
+            core_.MarkDirty(pr, SpeedCore::kDirtyAll);  // new save, nothing cached from the old one holds
+
             if (snapshotLoaded_.load(std::memory_order_relaxed)) {
-                const float snapCur = currentDelta;
-                const float snapDiag = diagDelta_;
-                const bool snapJog = joggingMode_;
-                const float snapSlope = slopeDeltaPlayer_;
+                const float snapCur = actors.moveDelta[p];
+                const float snapDiag = actors.diagDelta[p];
+                const bool snapJog = core_.joggingMode;
+                const float snapSlope = actors.slopeDelta[p];
 
-                ClearSlopeDeltaFor(pc);
-                RevertDeltasFor(pc);
+                core_.ClearSlopeDeltaFor(pr);
+                core_.RevertDeltasFor(pr);
 
                 float base = savedBaselineSM_;
                 if (!std::isfinite(base)) {
@@ -1024,477 +676,97 @@ void SpeedController::DoPostLoadCleanup() {
                 }
                 if (std::fabs(snapSlope) > 1e-6f) {
                     avo->ModActorValue(RE::ActorValue::kSpeedMult, snapSlope);
-                    slopeDeltaPlayer_ = snapSlope;
+                    actors.slopeDelta[p] = snapSlope;
                 }
 
                 if (std::fabs(snapCur) > 1e-6f) {
                     avo->ModActorValue(RE::ActorValue::kSpeedMult, snapCur);
-                    currentDelta = snapCur;
+                    actors.moveDelta[p] = snapCur;
                 }
                 if (std::fabs(snapDiag) > 1e-6f) {
                     avo->ModActorValue(RE::ActorValue::kSpeedMult, snapDiag);
-                    diagDelta_ = snapDiag;
+                    actors.diagDelta[p] = snapDiag;
                 }
-                joggingMode_ = snapJog;
+                core_.joggingMode = snapJog;
 
                 snapshotLoaded_.store(false, std::memory_order_relaxed);
 
-                ForceSpeedRefresh(pc);
+                core_.QueueRefresh(pr);
             } else {
-                RevertDeltasFor(pc);
-                currentDelta = 0.0f;
-                diagDelta_ = 0.0f;
-                attackDelta_ = 0.0f;
+                core_.RevertDeltasFor(pr);
+                actors.moveDelta[p] = 0.0f;
+                actors.diagDelta[p] = 0.0f;
+                actors.attackDelta[p] = 0.0f;
             }
 
-            moveX_ = 0.0f;
-            moveY_ = 0.0f;
-            lastApplyPlayerMs_ = NowMs();
+            core_.moveX = 0.0f;
+            core_.moveY = 0.0f;
+            rawMoveX_ = rawMoveY_ = 0.0f;
+            inputDirty_ = false;
+            actors.lastApplyMs[p] = NowMs();
         }
 
-        currentDeltaNPC_.clear();
-        attackDeltaNPC_.clear();
-        diagDeltaNPC_.clear();
+        core_.FlushRefreshes();  // empties the queue before the release, pendingRefresh_ below covers the player
+        actors.ReleaseAllNPCs();
 
         postLoadGraceUntilMs_.store(NowMs() + 800, std::memory_order_relaxed);
         postLoadNudges_.store(3, std::memory_order_relaxed);
         pendingRefresh_.store(true, std::memory_order_relaxed);
+        scheduler_.Reset();
 
         loading_.store(false, std::memory_order_relaxed);
+        WakeHeartbeat();
     });
 }
 
-bool SpeedController::UpdateDiagonalPenalty(RE::Actor* a) {
-    if (!a) return false;
-
-    float x = 0.f, y = 0.f;
-    if (a == RE::PlayerCharacter::GetSingleton()) {
-        x = moveX_;
-        y = moveY_;
-    } else {
-        (void)TryGetMoveAxesFromGraph(a, x, y);
-    }
-    return UpdateDiagonalPenalty(a, x, y);
-}
-
-bool SpeedController::UpdateDiagonalPenalty(RE::Actor* a, float inX, float inY) {
-    if (!a) return false;
-
-    // f = max(|x|,|y|) / sqrt(x^2 + y^2)   (<= 1)
-    const float ax = std::fabs(inX);
-    const float ay = std::fabs(inY);
-    const float mag = std::sqrt(inX * inX + inY * inY);
-    const float maxc = std::max(ax, ay);
-
-    float f = 1.0f;
-    if (mag > 1e-4f && maxc > 0.0f) f = std::min(1.0f, maxc / mag);
-
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return false;
-
-    float& slot = DiagDeltaSlot(a);
-
-    const float curSM = avo->GetActorValue(RE::ActorValue::kSpeedMult);
-    const float floor = Settings::minFinalSpeedMult.load();
-    const bool sprinting = IsSprintingLatched(a);
-
-    const float curNoDiag = curSM - slot;
-    float headroom = std::max(0.0f, curNoDiag - floor);
-
-    float newDiag = 0.0f;
-    if (f < 0.999f) {
-        newDiag = headroom * (f - 1.0f);  // <= 0
-        if (sprinting) newDiag *= 0.5f;
-    } else {
-        newDiag = 0.0f;
-    }
-
-    const float delta = newDiag - slot;
-
-    float& acc = DiagResidualSlot(a);
-    acc += delta;
-
-    static constexpr float kDiagGran = 5e-4f;
-    if (std::fabs(acc) >= kDiagGran) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, acc);
-        slot += acc;
-        acc = 0.0f;
-        return true;
-    }
-    return false;
-}
-
-float SpeedController::CaseToDelta(const RE::Actor* a) const {
-    const MoveCase c = ComputeCase(a);
-    float base = 0.0f;
-    switch (c) {
-        case MoveCase::Combat:
-            base = 0.0f;
-            break;
-        case MoveCase::Drawn:
-            base = -Settings::reduceDrawn.load();
-            break;
-        case MoveCase::Sneak:
-            base = -Settings::reduceSneak.load();
-            break;
-        default:
-            base = -(joggingMode_ ? Settings::reduceJoggingOutOfCombat.load() : Settings::reduceOutOfCombat.load());
-            break;
-    }
-
-    if (Settings::locationMode != Settings::LocationMode::Ignore &&
-        (Settings::locationAffects == Settings::LocationAffects::AllStates ||
-         (Settings::locationAffects == Settings::LocationAffects::DefaultOnly && (c == MoveCase::Default)))) {
-        RE::BGSLocation* loc = nullptr;
-        if (a) {
-            if (auto* l = a->GetCurrentLocation())
-                loc = l;
-            else if (auto* cell = a->GetParentCell())
-                loc = cell->GetLocation();
-        }
-        if (loc) {
-            // Specific
-            for (auto& fs : Settings::reduceInLocationSpecific) {
-                if (auto* l = LookupForm<RE::BGSLocation>(fs.plugin, fs.id); l && l == loc) {
-                    base = (Settings::locationMode == Settings::LocationMode::Replace) ? -fs.value : base - fs.value;
-                    goto done_loc;
-                }
-            }
-            // Types
-            if (auto* kwSet = loc->keywords) {
-                for (auto& fs : Settings::reduceInLocationType) {
-                    if (auto* kw = LookupForm<RE::BGSKeyword>(fs.plugin, fs.id); kw) {
-                        if (loc->HasKeyword(kw)) {
-                            base = (Settings::locationMode == Settings::LocationMode::Replace) ? -fs.value
-                                                                                               : base - fs.value;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
-done_loc:;
-    if (Settings::weatherEnabled.load() &&
-        (Settings::weatherAffects == Settings::WeatherAffects::AllStates ||
-         (Settings::weatherAffects == Settings::WeatherAffects::DefaultOnly && (c == MoveCase::Default)))) {
-        if (auto w = ComputeWeatherValue(a)) {
-            base = (Settings::weatherMode == Settings::WeatherMode::Replace) ? -(*w) : base - (*w);
-        }
-    }
-
-    bool sprint = IsSprintingLatched(a);
-    if (sprint) {
-        const MoveCase c = ComputeCase(a);
-        if (c != MoveCase::Combat || Settings::sprintAffectsCombat.load()) {
-            base += Settings::increaseSprinting.load();
-        }
-    }
-    if (Settings::armorAffectsMovement.load()) {
-        const float aw = ComputeArmorWeight(a);
-        float armDelta = Settings::armorWeightSlopeSM.load() * (aw - Settings::armorWeightPivot.load());
-        const float lo = Settings::armorMoveMin.load();
-        const float hi = Settings::armorMoveMax.load();
-        if (lo <= hi) {
-            armDelta = std::clamp(armDelta, lo, hi);
-        } else {
-            armDelta = std::clamp(armDelta, hi, lo);
-        }
-        base += armDelta;
-    }
-
-    {
-        float vit = 0.0f;
-        vit += LinearVitalPenaltyPct(a, RE::ActorValue::kHealth, Settings::healthEnabled.load(),
-                                     Settings::healthThresholdPct.load(), Settings::healthReducePct.load(),
-                                     Settings::healthSmoothWidthPct.load());
-        vit += LinearVitalPenaltyPct(a, RE::ActorValue::kStamina, Settings::staminaEnabled.load(),
-                                     Settings::staminaThresholdPct.load(), Settings::staminaReducePct.load(),
-                                     Settings::staminaSmoothWidthPct.load());
-        vit += LinearVitalPenaltyPct(a, RE::ActorValue::kMagicka, Settings::magickaEnabled.load(),
-                                     Settings::magickaThresholdPct.load(), Settings::magickaReducePct.load(),
-                                     Settings::magickaSmoothWidthPct.load());
-        base += vit;
-    }
-
-    if (Settings::scaleCompEnabled.load() && a && Settings::scaleCompMode == Settings::ScaleCompMode::Additive) {
-        const float s = GetPlayerScaleSafe(a);
-        if (!Settings::scaleCompOnlyBelowOne.load() || s < 1.0f) {
-            base += Settings::scaleCompPerUnitSM.load() * (1.0f - s);
-        }
-    }
-    return base;
-}
-
 void SpeedController::RefreshNow() {
-    Apply();
-    if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
-        ForceSpeedRefresh(pc);
-    }
+    // Called by the menu right after an edit: publish it now (the page publishes at its end), then run the pass on
+    // the game thread like every other core update
+    Settings::Publish();
+    SKSE::GetTaskInterface()->AddTask([this]() {
+        if (loading_.load(std::memory_order_relaxed)) return;
+        Apply();
+        if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
+            core_.QueueRefresh(Ref(pc));
+        }
+        core_.FlushRefreshes(npcBuf_);
+    });
 }
 
 void SpeedController::Apply() {
+    DSC_PROFILE_SCOPE(Diag::Stage::Apply);
+    // Empty unless this call reaches Tick, the flush after it must not see handles of an older pass
+    npcBuf_.clear();
     if (NowMs() < postLoadGraceUntilMs_.load(std::memory_order_relaxed)) return;
     if (loading_.load(std::memory_order_relaxed)) return;
     if (refreshGuard_.load(std::memory_order_relaxed)) return;
 
-    const bool cur = Settings::enableSpeedScalingForNPCs.load();
-    if (prevAffectNPCs_ && !cur) {
-        RevertAllNPCDeltas();
-    }
-    prevAffectNPCs_ = cur;
-
-    RE::PlayerCharacter* pc = RE::PlayerCharacter::GetSingleton();
-    if (!pc) return;
-
-    ApplyFor(pc);
-
-    static uint64_t lastNpcApplyMs = 0;
-    const uint64_t now = NowMs();
-    const int gapMs = std::max(0, Settings::eventDebounceMs.load());
-    const bool npcThrottled = (gapMs > 0 && lastNpcApplyMs != 0 && (now - lastNpcApplyMs) < (uint64_t)gapMs);
-
-    if (npcThrottled) {
-        UpdateSlopeTickNPCsOnly();
-        return;
-    }
-    lastNpcApplyMs = now;
-
-    ForEachTargetActor([&](RE::Actor* a) {
-        if (a != pc) ApplyFor(a);
-    });
-}
-
-void SpeedController::RevertMovementDeltasFor(RE::Actor* a, bool clearSlope) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-
-    // Movement-Delta
-    float& moveDelta = CurrentDeltaSlot(a);
-    if (std::fabs(moveDelta) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -moveDelta);
-        moveDelta = 0.0f;
-    }
-
-    // Diagonal-Delta
-    float& diag = DiagDeltaSlot(a);
-    if (std::fabs(diag) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -diag);
-        diag = 0.0f;
-    }
-
-    // Slope-Delta
-    if (clearSlope) {
-        ClearSlopeDeltaFor(a);
-    }
-
-    ForceSpeedRefresh(a);
-}
-
-void SpeedController::ApplyFor(RE::Actor* a) {
-    if (!a) return;
-
-    if (Settings::ignoreBeastForms.load() && IsInBeastForm(a)) {
-        RevertDeltasFor(a);
-        return;
-    }
-
-    const bool isPlayer = (a == RE::PlayerCharacter::GetSingleton());
-    if (!isPlayer) {
-        if (!IsWithinNPCProcRadius(a)) {
-            RevertDeltasFor(a);
-            ClearNPCState(GetID(a));
-            return;
-        }
-    }
-
-    const auto id = GetID(a);
-    float want = CaseToDelta(a);
-
-    if (!isPlayer) {
-        const float pct = std::clamp(Settings::npcPercentOfPlayer.load(), 0.0f, 200.0f) * 0.01f;
-        want *= pct;
-    }
-
-    float& cur = isPlayer ? currentDelta : currentDeltaNPC_[id];
-    uint64_t& t = isPlayer ? lastApplyPlayerMs_ : lastApplyNPCMs_[id];
+    // One snapshot for the whole pass, the rules are rebuilt from the same one before the core resolves anything
+    core_.SyncSettings();
+    const auto& cfg = core_.Config();
+    rules_.EnsureCurrent(*cfg.rules);
 
-    uint64_t now = NowMs();
-    float dt = 0.0f;
-    if (t == 0) {
-        dt = 1.0f / 60.0f;
-    } else {
-        dt = std::max(0.0f, (now - t) / 1000.0f);
-    }
-    t = now;
-
-    bool smoothing = Settings::smoothingEnabled.load() && (isPlayer || Settings::smoothingAffectsNPCs.load());
-
-    // Flip-Logic: Always invalidate diagonal penalty
-    const bool curSprint = IsSprintingLatched(a);
-    const bool curSneak = a->IsSneaking();
-    const bool curDrawn = IsWeaponDrawnByState(a);
-    bool flip = false;
-
-    if (isPlayer) {
-        flip = (curSprint != prevPlayerSprinting_) || (curSneak != prevPlayerSneak_) || (curDrawn != prevPlayerDrawn_);
-        prevPlayerSprinting_ = curSprint;
-        prevPlayerSneak_ = curSneak;
-        prevPlayerDrawn_ = curDrawn;
-    } else {
-        auto id = GetID(a);
-        bool& pS = prevNPCSprinting_[id];
-        bool& pN = prevNPCSneak_[id];
-        bool& pD = prevNPCDrawn_[id];
-        flip = (curSprint != pS) || (curSneak != pN) || (curDrawn != pD);
-        pS = curSprint;
-        pN = curSneak;
-        pD = curDrawn;
-    }
-
-    if (flip) {
-        // immediately reject Diagonal-Delta, so Headroom/Clamp fits exactly
-        ClearDiagDeltaFor(const_cast<RE::Actor*>(a));
-        if (Settings::smoothingBypassOnStateChange.load() && smoothing) {
-            smoothing = false;
-            RevertMovementDeltasFor(a, false);
+    auto& npcs = npcBuf_;
+    if (auto* pl = RE::ProcessLists::GetSingleton()) {
+        for (auto& h : pl->highActorHandles) {
+            if (RE::Actor* a = h.get().get()) npcs.push_back(Ref(a));
         }
-        ForceSpeedRefresh(a);
     }
 
-    float newDelta = want;
-    if (smoothing) {
-        newDelta = SmoothCombined(cur, want, dt);
-    }
-
-    float diff = newDelta - cur;
-
-    if (auto* avo = a->AsActorValueOwner()) {
-        const float floor = Settings::minFinalSpeedMult.load();
-
-        float& curSlot = isPlayer ? currentDelta : currentDeltaNPC_[id];
-        float& diagSlot = DiagDeltaSlot(a);
-        float& slopeSlot = SlopeDeltaSlot(a);
-        float& scaleSlot = ScaleDeltaSlot(a);
-
-        const float curSM = avo->GetActorValue(RE::ActorValue::kSpeedMult);
-        const float baseNoUs = curSM - curSlot - diagSlot - slopeSlot;
-
-        bool wantDiag =
-            isPlayer ? Settings::enableDiagonalSpeedFix.load() : Settings::enableDiagonalSpeedFixForNPCs.load();
-
-        float predictedDiag = 0.0f;
-        if (wantDiag) {
-            float x = 0.f, y = 0.f;
-            const bool sprinting = IsSprintingLatched(a);
-            if (isPlayer) {
-                x = moveX_;
-                y = moveY_;
-            } else {
-                (void)TryGetMoveAxesFromGraph(a, x, y);
-            }
-            predictedDiag = PredictDiagonalPenalty(baseNoUs + newDelta, floor, x, y, sprinting);
-        }
-
-        float expectedNoScaleFinal = baseNoUs + newDelta + predictedDiag + slopeSlot;
-
-        float sFactor = 1.0f;
-        if (Settings::scaleCompEnabled.load() && Settings::scaleCompMode == Settings::ScaleCompMode::Inverse) {
-            const float s = GetPlayerScaleSafe(a);
-            if (!Settings::scaleCompOnlyBelowOne.load() || s < 1.0f) sFactor = 1.0f / s;
-        }
-
-        float expectedFinal = expectedNoScaleFinal * sFactor;
-
-
-        if (Settings::slopeClampEnabled.load()) {
-            const float lo = Settings::slopeMinFinal.load();
-            const float hi = Settings::slopeMaxFinal.load();
-            if (expectedFinal < lo) {
-                newDelta += (lo - expectedFinal);
-                expectedFinal = lo;
-            } else if (expectedFinal > hi) {
-                newDelta -= (expectedFinal - hi);
-                expectedFinal = hi;
-            }
-        }
-
-        if (expectedFinal < floor) {
-            const float needed = floor - expectedFinal;
-            newDelta += needed;
-            expectedNoScaleFinal += needed;
-            expectedFinal = expectedNoScaleFinal * sFactor;
-        }
-
-        diff = newDelta - curSlot;
-    }
-
-    bool moveChanged = false;
-    if (std::fabs(diff) > 0.0001f) {
-        ModSpeedMult(a, diff);
-        cur = newDelta;
-        moveChanged = true;
-    }
-
-    const bool wantDiag =
-        (isPlayer ? Settings::enableDiagonalSpeedFix.load() : Settings::enableDiagonalSpeedFixForNPCs.load());
-
-    bool diagChanged = false;
-    if (wantDiag) {
-        diagChanged = UpdateDiagonalPenalty(a);
-    } else {
-        ClearDiagDeltaFor(a);
-    }
-
-    const bool slopeChanged = UpdateSlopePenalty(a, dt);
-
-    bool scaleChanged = false;
-    if (Settings::scaleCompEnabled.load() && Settings::scaleCompMode == Settings::ScaleCompMode::Inverse) {
-        if (auto* avo2 = a->AsActorValueOwner()) {
-            float x = 0.f, y = 0.f;
-            const bool sprinting = IsSprintingLatched(a);
-            if (isPlayer) {
-                x = moveX_;
-                y = moveY_;
-            } else {
-                (void)TryGetMoveAxesFromGraph(a, x, y);
-            }
-
-            const float floor = Settings::minFinalSpeedMult.load();
-
-            float& curSlot2 = isPlayer ? currentDelta : currentDeltaNPC_[id];
-            float& diagSlot2 = DiagDeltaSlot(a);
-            float& slopeSlot2 = SlopeDeltaSlot(a);
-
-            const float curSM2 = avo2->GetActorValue(RE::ActorValue::kSpeedMult);
-            const float baseNoUs2 = curSM2 - curSlot2 - diagSlot2 - slopeSlot2;
-            const float predictedDiag2 = PredictDiagonalPenalty(baseNoUs2 + curSlot2, floor, x, y, sprinting);
-            const float noScaleFinalPreview = baseNoUs2 + curSlot2 + predictedDiag2 + slopeSlot2;
-
-            scaleChanged = UpdateScaleCompDelta(a, noScaleFinalPreview);
-        }
-    } else {
-        ClearScaleDeltaFor(a);
+    const bool cur = cfg.enableSpeedScalingForNPCs;
+    if (prevAffectNPCs_ && !cur) {
+        core_.BeginNPCRevert();
     }
+    prevAffectNPCs_ = cur;
 
-    if (isPlayer) {
-        if (slopeChanged) {
-            pendingRefresh_.store(true, std::memory_order_relaxed);
-        }
-    } else {
-        if (moveChanged || diagChanged || slopeChanged || scaleChanged) {
-            ForceSpeedRefresh(a);
-        }
+    RE::PlayerCharacter* pc = RE::PlayerCharacter::GetSingleton();
+    if (!pc) {
+        npcs.clear();
+        return;
     }
 
-    ClampSpeedFloorTracked(a);
-}
-
-void SpeedController::ModSpeedMult(RE::Actor* actor, float delta) {
-    if (!actor) return;
-    RE::ActorValueOwner* avo = actor->AsActorValueOwner();
-    avo->ModActorValue(RE::ActorValue::kSpeedMult, delta);
+    core_.SetPlayer(Ref(pc));
+    core_.Tick(npcs);
 }
 
 bool SpeedController::ForceSpeedRefresh(RE::Actor* actor) {
@@ -1507,20 +779,8 @@ bool SpeedController::ForceSpeedRefresh(RE::Actor* actor) {
         return false;
     }
 
-    const bool isPlayer = (actor == RE::PlayerCharacter::GetSingleton());
-    uint64_t prev =
-        isPlayer ? lastRefreshPlayerMs_.load(std::memory_order_relaxed) : lastRefreshNPCMs_[actor->GetFormID()];
-
-    if (prev != 0 && (now - prev) < 25) {
-        return false;
-    }
-
-    if (isPlayer) {
-        lastRefreshPlayerMs_.store(now, std::memory_order_relaxed);
-    } else {
-        lastRefreshNPCMs_[actor->GetFormID()] = now;
-    }
-
+    DSC_PROFILE_SCOPE(Diag::Stage::ForceSpeedRefresh);
+    DSC_COUNT(Diag::Counter::Refreshes, 1);
     if (auto* avo = actor->AsActorValueOwner()) {
         const float before = avo->GetActorValue(RE::ActorValue::kCarryWeight);
 
@@ -1567,251 +827,20 @@ bool SpeedController::IsWeaponDrawnByState(const RE::Actor* a) {
     return any;
 }
 
-bool SpeedController::IsSprintingByGraph(const RE::Actor* a) {
-    if (!a) return false;
-    bool b = false;
-    if (a->GetGraphVariableBool("IsSprinting", b) && b) return true;
-    if (a->GetGraphVariableBool("bIsSprinting", b) && b) return true;
-    if (a->GetGraphVariableBool("bSprint", b) && b) return true;
-    return false;
-}
+bool SpeedController::IsSprintingByGraph(const RE::Actor* a) const { return graphVars_.IsSprinting(a); }
 
-bool SpeedController::IsInBeastForm(const RE::Actor* a) {
+// Resolved beast race set first, the graph flags catch transformation races nobody listed
+bool SpeedController::IsInBeastForm(const RE::Actor* a) const {
     if (!a) return false;
-
-    if (RaceIs(a, "WerewolfBeastRace")) return true;
-    if (RaceIs(a, "DLC1VampireBeastRace")) return true;
-
-    bool b = false;
-    if ((a->GetGraphVariableBool("IsWerewolf", b) && b) || (a->GetGraphVariableBool("bIsWerewolf", b) && b) ||
-        (a->GetGraphVariableBool("IsVampireLord", b) && b) || (a->GetGraphVariableBool("bIsVampireLord", b) && b)) {
-        return true;
-    }
-    return false;
-}
-
-void SpeedController::UpdateSlopeTickOnly() {
-    // Player
-    if (auto* pc = RE::PlayerCharacter::GetSingleton()) {
-        const uint64_t now = NowMs();
-        float dt = (lastSlopePlayerMs_ == 0) ? (1.0f / 60.0f) : std::max(0.0f, (now - lastSlopePlayerMs_) / 1000.0f);
-        lastSlopePlayerMs_ = now;
-
-        bool pChanged = UpdateSlopePenalty(pc, dt);
-        if (pChanged) {
-            pendingRefresh_.store(true, std::memory_order_relaxed);
-        }
-        ClampSpeedFloorTracked(pc);
-    }
-
-    // NPCs
-    if (Settings::enableSpeedScalingForNPCs.load()) {
-        auto* pl = RE::ProcessLists::GetSingleton();
-        if (pl) {
-            for (auto& h : pl->highActorHandles) {
-                RE::Actor* a = h.get().get();
-                if (!a) continue;
-                const auto id = GetID(a);
-
-                if (!IsWithinNPCProcRadius(a)) {
-                    RevertDeltasFor(a);
-                    ClearNPCState(id);
-                    continue;
-                }
-
-                const uint64_t now = NowMs();
-                uint64_t& t = lastSlopeNPCMs_[id];
-                float dt = (t == 0) ? (1.0f / 60.0f) : std::max(0.0f, (now - t) / 1000.0f);
-                t = now;
-
-                bool aChanged = UpdateSlopePenalty(a, dt);
-                if (aChanged) {
-                    ForceSpeedRefresh(a);
-                }
-                ClampSpeedFloorTracked(a);
-            }
-        }
-    }
-}
-
-void SpeedController::UpdateSlopeTickNPCsOnly() {
-    if (!Settings::enableSpeedScalingForNPCs.load()) return;
-    auto* pl = RE::ProcessLists::GetSingleton();
-    if (!pl) return;
-
-    for (auto& h : pl->highActorHandles) {
-        RE::Actor* a = h.get().get();
-        if (!a) continue;
-
-        const auto id = GetID(a);
-
-        if (!IsWithinNPCProcRadius(a)) {
-            RevertDeltasFor(a);
-            ClearNPCState(id);
-            continue;
-        }
-
-        const uint64_t now = NowMs();
-        uint64_t& t = lastSlopeNPCMs_[id];
-        float dt = (t == 0) ? (1.0f / 60.0f) : std::max(0.0f, (now - t) / 1000.0f);
-        t = now;
-
-        bool changed = UpdateSlopePenalty(a, dt);
-        if (changed) {
-            ForceSpeedRefresh(a);
-        }
-        ClampSpeedFloorTracked(a);
-    }
-}
-
-void SpeedController::RevertDeltasFor(RE::Actor* a) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-
-    float& moveDelta = CurrentDeltaSlot(a);
-    if (std::fabs(moveDelta) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -moveDelta);
-        moveDelta = 0.0f;
-    }
-
-    float& atkDelta = AttackDeltaSlot(a);
-    if (std::fabs(atkDelta) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kWeaponSpeedMult, -atkDelta);
-        atkDelta = 0.0f;
-    }
-
-    float& diag = DiagDeltaSlot(a);
-    if (std::fabs(diag) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -diag);
-        diag = 0.0f;
-    }
-
-    float& sc = ScaleDeltaSlot(a);
-    if (std::fabs(sc) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -sc);
-        sc = 0.0f;
-    }
-
-    ClearSlopeDeltaFor(a);
-    ForceSpeedRefresh(a);
-
-    DiagResidualSlot(a) = 0.0f;
-    SlopeResidualSlot(a) = 0.0f;
-    ScaleResidualSlot(a) = 0.0f;
+    if (rules_.IsBeastRace(a->GetRace())) return true;
+    return graphVars_.HasBeastFlag(a);
 }
 
 bool SpeedController::TryGetMoveAxesFromGraph(const RE::Actor* a, float& outX, float& outY) const {
-    if (!a) return false;
-    float x = 0.0f, y = 0.0f;
-    bool ok = false;
-
-    if (a->GetGraphVariableFloat("MoveX", x)) ok = true;
-    if (a->GetGraphVariableFloat("MoveY", y)) ok = true;
-
-    float t = 0.0f;
-    if (!ok) {
-        if (a->GetGraphVariableFloat("SpeedSide", x)) ok = true;
-        if (a->GetGraphVariableFloat("SpeedForward", y)) ok = true;
-    }
-    if (!ok) {
-        if (a->GetGraphVariableFloat("Strafe", x)) ok = true;
-        if (a->GetGraphVariableFloat("Forward", y)) ok = true;
-    }
-
-    if (!ok) return false;
-    outX = x;
-    outY = y;
+    if (!graphVars_.GetMoveAxes(a, outX, outY)) return false;
     return (std::fabs(outX) > 1e-4f) || (std::fabs(outY) > 1e-4f);
 }
 
-float& SpeedController::DiagDeltaSlot(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return diagDelta_;
-    return diagDeltaNPC_[GetID(a)];
-}
-
-float& SpeedController::ScaleDeltaSlot(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return scaleDeltaPlayer_;
-    return scaleDeltaNPC_[GetID(a)];
-}
-
-void SpeedController::ClearScaleDeltaFor(RE::Actor* a) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-    float& slot = ScaleDeltaSlot(a);
-    if (std::fabs(slot) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -slot);
-        slot = 0.0f;
-    }
-    ScaleResidualSlot(a) = 0.0f;
-}
-
-bool SpeedController::UpdateScaleCompDelta(RE::Actor* a, float predictedNoScaleFinal) {
-    if (!a) return false;
-    if (!Settings::scaleCompEnabled.load()) {
-        ClearScaleDeltaFor(a);
-        return false;
-    }
-    if (Settings::scaleCompMode != Settings::ScaleCompMode::Inverse) {
-        ClearScaleDeltaFor(a);
-        return false;
-    }
-
-    const float s = GetPlayerScaleSafe(a);
-    if (Settings::scaleCompOnlyBelowOne.load() && s >= 1.0f) {
-        // No inverse correction above 1.0
-        ClearScaleDeltaFor(a);
-        return false;
-    }
-    const float factor = 1.0f / std::max(0.01f, s);
-    const float K = factor - 1.0f;
-
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return false;
-
-    float& slot = ScaleDeltaSlot(a);
-    const float target = K * predictedNoScaleFinal;  // make final = noScale * factor
-    const float delta = target - slot;
-
-    float& acc = ScaleResidualSlot(a);
-    acc += delta;
-
-    static constexpr float kGran = 5e-4f;
-    if (std::fabs(acc) >= kGran) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, acc);
-        slot += acc;
-        acc = 0.0f;
-        return true;
-    }
-    return false;
-}
-
-void SpeedController::ClearDiagDeltaFor(RE::Actor* a) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-    float& slot = DiagDeltaSlot(a);
-    if (std::fabs(slot) > 1e-6f) {
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, -slot);
-        slot = 0.0f;
-    }
-    DiagResidualSlot(a) = 0.0f;
-}
-
-std::deque<PathSample>& SpeedController::PathBuf(RE::Actor* a) {
-    auto* pc = RE::PlayerCharacter::GetSingleton();
-    if (a == pc) return pathPlayer_;
-    return pathNPC_[GetID(a)];
-}
-
-void SpeedController::ClearPathFor(RE::Actor* a) {
-    auto& q = PathBuf(a);
-    q.clear();
-}
-
 bool SpeedController::IsSprintingLatched(const RE::Actor* a) const {
     if (!a) return false;
     if (IsSprintingByGraph(a)) return true;
@@ -1824,87 +853,25 @@ bool SpeedController::IsSprintingLatched(const RE::Actor* a) const {
     return false;
 }
 
-void SpeedController::PushPathSample(RE::Actor* a, const RE::NiPoint3& pos, uint64_t nowMs) {
-    auto& q = PathBuf(a);
-    float sxy = 0.0f;
-    if (!q.empty()) {
-        const auto& last = q.back();
-        const float dx = pos.x - last.x;
-        const float dy = pos.y - last.y;
-        const float dxy = std::sqrt(dx * dx + dy * dy);
-        if (dxy < Settings::slopeMinXYPerFrame.load()) {
-            sxy = last.sxy;
-        } else {
-            sxy = last.sxy + dxy;
-        }
-    }
-    q.push_back(PathSample{pos.x, pos.y, pos.z, sxy, nowMs});
-
-    const uint64_t maxAgeMs = static_cast<uint64_t>(std::max(0.f, Settings::slopeMaxHistorySec.load()) * 1000.f);
-    while (!q.empty() && (nowMs - q.front().tMs) > maxAgeMs) {
-        q.pop_front();
-    }
-}
-
-void SpeedController::ClampSpeedFloorTracked(RE::Actor* a) {
-    if (!a) return;
-    auto* avo = a->AsActorValueOwner();
-    if (!avo) return;
-
-    const float floor = Settings::minFinalSpeedMult.load();
-
-    float& moveSlot = CurrentDeltaSlot(a);
-    float& diagSlot = DiagDeltaSlot(a);
-    float& slopeSlot = SlopeDeltaSlot(a);
-
-    const float cur = avo->GetActorValue(RE::ActorValue::kSpeedMult);
-
-    const float eps = 1e-4f;
-    if (cur < floor - eps) {
-        const float need = floor - cur;
-        avo->ModActorValue(RE::ActorValue::kSpeedMult, need);
-        moveSlot += need;
-    }
-}
-
-bool SpeedController::ComputePathSlopeDeg(RE::Actor* a, float lookbackUnits, float maxAgeSec, float& outDeg) {
-    auto& q = PathBuf(a);
-    if (q.size() < 2) return false;
-
-    const auto& cur = q.back();
-    const float wantSxy = std::max(0.f, cur.sxy - std::max(lookbackUnits, 0.0f));
-
-    const PathSample* ref = nullptr;
-    for (int i = static_cast<int>(q.size()) - 1; i >= 0; --i) {
-        if (q[static_cast<size_t>(i)].sxy <= wantSxy) {
-            ref = &q[static_cast<size_t>(i)];
-            break;
-        }
-    }
-    if (!ref) ref = &q.front();
-
-    const float dxy = std::max(1e-3f, cur.sxy - ref->sxy);
-    const float dz = cur.z - ref->z;
-    outDeg = std::clamp(std::atan2(dz, dxy) * 57.29578f, -85.0f, 85.0f);
-    return true;
-}
-
-float SpeedController::ComputeArmorWeight(const RE::Actor* a) const {
-    if (!a) return 0.0f;
+ArmorWeight SpeedController::ComputeArmorWeight(const RE::Actor* a) const {
+    if (!a) return {};
 
     float maxW = 0.0f, sumW = 0.0f;
 
     auto* ac = const_cast<RE::Actor*>(a);
 
-    std::unordered_set<RE::FormID> seen;
+    // An item covering several slots is returned once per slot, count it once
+    std::array<const RE::TESObjectARMO*, 32> seen{};
+    std::size_t numSeen = 0;
 
-    for (std::uint32_t i = 0; i <= 31; ++i) {
-        const auto slot = static_cast<RE::BGSBipedObjectForm::BipedObjectSlot>(i);
+    for (std::uint32_t i = 0; i < 32; ++i) {
+        const auto slot = static_cast<RE::BGSBipedObjectForm::BipedObjectSlot>(1u << i);
         RE::TESObjectARMO* armo = ac->GetWornArmor(slot, true);
         if (!armo) continue;
 
-        const RE::FormID fid = armo->GetFormID();
-        if (!seen.insert(fid).second) continue;
+        const auto seenEnd = seen.begin() + numSeen;
+        if (std::find(seen.begin(), seenEnd, armo) != seenEnd) continue;
+        seen[numSeen++] = armo;
 
         const RE::TESBoundObject* bo = armo;
         const float w = bo ? bo->GetWeight() : 0.0f;
@@ -1913,11 +880,11 @@ float SpeedController::ComputeArmorWeight(const RE::Actor* a) const {
         if (w > maxW) maxW = w;
     }
 
-    return Settings::useMaxArmorWeight.load() ? maxW : sumW;
+    return ArmorWeight{sumW, maxW};
 }
 
-bool SpeedController::GetJoggingMode() const { return joggingMode_; }
-void SpeedController::SetJoggingMode(bool b) { joggingMode_ = b; }
+bool SpeedController::GetJoggingMode() const { return core_.joggingMode; }
+void SpeedController::SetJoggingMode(bool b) { core_.joggingMode = b; }
 
-float SpeedController::GetCurrentDelta() const { return currentDelta; }
-void SpeedController::SetCurrentDelta(float d) { currentDelta = d; }
+float SpeedController::GetCurrentDelta() const { return core_.Actors().moveDelta[ActorStateTable::kPlayerSlot]; }
+void SpeedController::SetCurrentDelta(float d) { core_.Actors().moveDelta[ActorStateTable::kPlayerSlot] = d; }
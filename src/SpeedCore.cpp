@@ -0,0 +1,1429 @@
+#include "SpeedCore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "BatchMath.h"
+#include "Diagnostics.h"
+#include "MovementMath.h"
+
+namespace {
+    inline float SanitizeScale(float s) {
+        if (s <= 0.01f || s > 10.0f) s = 1.0f;
+        return s;
+    }
+
+    inline float NPCPercent(const Settings::Snapshot& c) {
+        return std::clamp(c.npcPercentOfPlayer, 0.0f, 200.0f) * 0.01f;
+    }
+
+    // SpeedCore::StateKey bits
+    constexpr std::uint8_t kKeyCombat = 1 << 0;
+    constexpr std::uint8_t kKeySneak = 1 << 1;
+    constexpr std::uint8_t kKeyDrawn = 1 << 2;
+    constexpr std::uint8_t kKeySprint = 1 << 3;
+    constexpr std::uint8_t kKeyJogging = 1 << 4;
+    constexpr std::uint8_t kKeyHasLocation = 1 << 5;
+    constexpr std::uint8_t kKeyHasWeather = 1 << 6;
+
+    // UpdateSlopePenalty's guards
+    inline bool SlopeActive(const Settings::Snapshot& c, bool isPlayer, float dt) {
+        return dt > 0.f && c.slopeEnabled && (isPlayer || c.slopeAffectsNPCs);
+    }
+}
+
+void SpeedCore::Tick(std::span<const ActorRef> npcs) {
+    if (!player_) return;
+    ResolveWeather();
+
+    ActorInputs pin;
+    Gather(player_, pin);
+    {
+        // Player displacement counts as activity even without input (carried, falling, mounted)
+        const float dx = pin.pos.x - playerPos_.x;
+        const float dy = pin.pos.y - playerPos_.y;
+        const float dz = pin.pos.z - playerPos_.z;
+        if (dx * dx + dy * dy + dz * dz > kActivityMoveEps * kActivityMoveEps) active_ = true;
+    }
+    playerPos_ = pin.pos;
+    ApplyFor(player_, pin);
+    DSC_COUNT(Diag::Counter::ActorsProcessed, 1);
+
+    const std::uint64_t now = pin.nowMs;
+    const int gapMs = std::max(0, settings_->eventDebounceMs);
+    const bool npcThrottled =
+        (gapMs > 0 && lastNpcApplyMs_ != 0 && (now - lastNpcApplyMs_) < static_cast<std::uint64_t>(gapMs));
+
+    if (npcThrottled) {
+        UpdateSlopeTickNPCsOnly(npcs);
+        return;
+    }
+    const std::uint64_t prevNpcApplyMs = lastNpcApplyMs_;
+    lastNpcApplyMs_ = now;
+
+    if (!settings_->enableSpeedScalingForNPCs) {
+        if (revertPending_) StepNPCRevert(npcs);
+        return;
+    }
+    revertPending_ = false;
+
+    const std::size_t n = npcs.size();
+    lastLod_ = {};
+    slice_.total = static_cast<std::uint32_t>(n);
+    slice_.processed = 0;
+    if (n == 0) return;
+    if (npcCursor_ >= n) npcCursor_ = 0;
+
+    // Lower bound per tick, so one lap never takes longer than npcMaxStaleMs, budget or not
+    const std::uint64_t dtMs = (prevNpcApplyMs != 0 && now > prevNpcApplyMs) ? (now - prevNpcApplyMs) : 33;
+    const std::uint64_t staleMs = static_cast<std::uint64_t>(std::max(1, settings_->npcMaxStaleMs));
+    const std::size_t minCount = std::min<std::size_t>(n, (n * dtMs + staleMs - 1) / staleMs);
+
+    const auto start = Clock::now();
+    std::size_t processed = 0;
+    while (processed < n) {
+        const std::size_t chunk = std::min(kSliceChunk, n - processed);
+        inputs_.resize(chunk);
+        due_.assign(chunk, 0);
+
+        // Gather stage: one engine read pass over the chunk ...
+        for (std::size_t k = 0; k < chunk; ++k) {
+            const auto& a = npcs[(npcCursor_ + processed + k) % n];
+            if (a && !a.IsPlayer()) due_[k] = GatherNPC(a, inputs_[k]);
+        }
+        PrecomputeChunk(npcs, npcCursor_ + processed, chunk);
+        // ... then the update stages, which only touch the snapshots and the ledger
+        for (std::size_t k = 0; k < chunk; ++k) {
+            if (!due_[k]) continue;
+            ApplyFor(npcs[(npcCursor_ + processed + k) % n], inputs_[k]);
+            ++lastLod_.updated;
+        }
+        processed += chunk;
+
+        if (processed < n && processed >= minCount && OverBudget(start, settings_->npcBudgetUs)) {
+            ++slice_.budgetStops;
+            break;
+        }
+    }
+
+    npcCursor_ = (npcCursor_ + processed) % n;
+    slice_.processed = static_cast<std::uint32_t>(processed);
+    DSC_COUNT(Diag::Counter::ActorsProcessed, lastLod_.updated);
+
+    lapDone_ += processed;
+    if (lapStartMs_ == 0) lapStartMs_ = now - dtMs;  // first lap started with the previous tick
+    if (lapDone_ >= n) {
+        slice_.roundTripMs = now - lapStartMs_;
+        lapDone_ = 0;
+        lapStartMs_ = now;
+    }
+}
+
+void SpeedCore::PrecomputeChunk(std::span<const ActorRef> npcs, std::size_t first, std::size_t chunk) {
+    const std::size_t n = npcs.size();
+    const float pct = NPCPercent(*settings_);
+    const bool slopeAngle = settings_->slopeMethod == 1;
+    const float lookback = settings_->slopeLookbackUnits;
+
+    auto& L = lanes_;
+    std::size_t m = 0, ms = 0;
+    for (std::size_t k = 0; k < chunk; ++k) {
+        auto& in = inputs_[k];
+        if (!due_[k] || in.beast || !in.inRange) continue;
+
+        const auto& a = npcs[(first + k) % n];
+        const auto s = SlotOf(a);
+        const float dt = StepDt(s, in.nowMs);
+
+        in.pre.want = MovementTarget(s, in) * pct;
+        L.move[m] = static_cast<std::uint8_t>(k);
+        L.prev[m] = actors_.moveDelta[s];
+        L.target[m] = in.pre.want;
+        L.dt[m] = dt;
+        L.x[m] = in.moveX;
+        L.y[m] = in.moveY;
+        ++m;
+
+        // The path sample goes in now (nothing before UpdateSlopePenalty reads the ring), so the lookback
+        // search can run here and only the angle is left for the kernel
+        if (!in.reduced && SlopeActive(*settings_, false, dt)) {
+            PushPathSample(s, in.pos, in.nowMs);
+            in.pre.pathPushed = true;
+            if (slopeAngle && MovementMath::PathSlopeRef(actors_.path[s], lookback, L.dz[ms], L.dxy[ms])) {
+                L.slope[ms++] = static_cast<std::uint8_t>(k);
+            }
+        }
+    }
+    if (m == 0) return;
+
+    if (settings_->smoothingEnabled && settings_->smoothingAffectsNPCs) {
+        BatchMath::Smooth(moveFilter_, L.prev.data(), L.target.data(), L.dt.data(), L.smoothed.data(), m);
+    } else {
+        std::copy_n(L.target.begin(), m, L.smoothed.begin());
+    }
+    BatchMath::DiagonalFactor(L.x.data(), L.y.data(), L.diag.data(), m);
+    if (ms > 0) BatchMath::SlopeDeg(L.dz.data(), L.dxy.data(), L.deg.data(), ms);
+
+    for (std::size_t i = 0; i < m; ++i) {
+        auto& pre = inputs_[L.move[i]].pre;
+        pre.smoothed = L.smoothed[i];
+        pre.diagFactor = L.diag[i];
+        pre.valid = true;
+    }
+    for (std::size_t i = 0; i < ms; ++i) {
+        auto& pre = inputs_[L.slope[i]].pre;
+        pre.slopeDeg = L.deg[i];
+        pre.haveSlope = true;
+    }
+}
+
+float SpeedCore::StepDt(ActorStateTable::Slot s, std::uint64_t nowMs) const {
+    const std::uint64_t t = actors_.lastApplyMs[s];
+    if (t == 0) return 1.0f / 60.0f;
+    return std::max(0.0f, (nowMs - t) / 1000.0f);
+}
+
+SpeedCore::LodTier SpeedCore::ClassifyLod(const Vec3& pos, LodTier prev) const {
+    const float dx = pos.x - playerPos_.x;
+    const float dy = pos.y - playerPos_.y;
+    const float d = std::sqrt(dx * dx + dy * dy);  // XY, same as the radius check
+
+    const int r = settings_->npcRadius;
+    const float nearR = static_cast<float>(std::max(0, settings_->npcLodNearRadius));
+    const float midR = std::max(nearR, static_cast<float>(settings_->npcLodMidRadius));
+    const float outR = (r <= 0) ? std::numeric_limits<float>::max() : std::max(midR, static_cast<float>(r));
+    const float edge[3] = {nearR, midR, outR};
+
+    const auto raw = d < edge[0]   ? LodTier::Near
+                     : d < edge[1] ? LodTier::Mid
+                     : d < edge[2] ? LodTier::Far
+                                   : LodTier::Out;
+    if (raw == prev) return raw;
+
+    // Stay in prev while inside its band widened by the hysteresis
+    const float h = static_cast<float>(std::max(0, settings_->npcLodHysteresis));
+    const auto p = static_cast<int>(prev);
+    const float lo = (p == 0) ? 0.0f : edge[p - 1] - h;
+    const float hi = (p == 3) ? std::numeric_limits<float>::max() : edge[p] + h;
+    return (d >= lo && d < hi) ? prev : raw;
+}
+
+bool SpeedCore::GatherNPC(ActorRef a, ActorInputs& in) {
+    if (!settings_->npcLodEnabled) {
+        Gather(a, in);
+        return true;
+    }
+
+    in = ActorInputs{};
+    in.nowMs = access_.NowMs();
+    in.pos = access_.GetPosition(a);
+
+    const auto found = actors_.Find(a.formID);
+    const auto prev = (found == ActorStateTable::kNoSlot) ? LodTier::Out : static_cast<LodTier>(actors_.lodTier[found]);
+    const auto tier = ClassifyLod(in.pos, prev);
+    ++lastLod_.tier[static_cast<int>(tier)];
+
+    if (tier == LodTier::Out) {
+        // Nothing of ours on an actor without a slot, otherwise ApplyFor reverts and releases it
+        if (found == ActorStateTable::kNoSlot) return false;
+        in.inRange = false;
+        return true;
+    }
+
+    const auto s = SlotOf(a);
+    const bool entered = (tier != prev);
+    actors_.lodTier[s] = static_cast<std::uint8_t>(tier);
+
+    switch (tier) {
+        case LodTier::Mid: {
+            auto& cd = actors_.lodCountdown[s];
+            if (!entered && cd > 0) {
+                --cd;
+                return false;
+            }
+            cd = static_cast<std::uint8_t>(std::clamp(settings_->npcLodMidInterval, 1, 60) - 1);
+            break;
+        }
+        case LodTier::Far:
+            if (!entered) {
+                // Cheap state probe, the full gather only on a flip or a pending equip change
+                const bool flip = actors_.armorCache[s].equipPending ||
+                                  access_.IsSprinting(a) != static_cast<bool>(actors_.prevSprinting[s]) ||
+                                  access_.IsSneaking(a) != static_cast<bool>(actors_.prevSneak[s]) ||
+                                  access_.IsWeaponDrawn(a) != static_cast<bool>(actors_.prevDrawn[s]) ||
+                                  access_.IsInCombat(a) != static_cast<bool>(actors_.prevCombat[s]);
+                if (!flip) return false;
+            }
+            break;
+        default:
+            break;
+    }
+
+    Gather(a, in, false);
+    in.reduced = (tier != LodTier::Near);
+    return true;
+}
+
+bool SpeedCore::InRadius(const Vec3& pos) const {
+    const int r = settings_->npcRadius;
+    if (r <= 0) return true;
+
+    const float dx = pos.x - playerPos_.x;
+    const float dy = pos.y - playerPos_.y;
+    const float r2 = static_cast<float>(r) * static_cast<float>(r);
+    return (dx * dx + dy * dy) <= r2;  // XY-Radius
+}
+
+bool SpeedCore::IsWithinNPCProcRadius(ActorRef a) const {
+    if (!a || !player_) return false;
+    if (a.IsPlayer()) return true;
+
+    const int r = settings_->npcRadius;
+    if (r <= 0) return true;
+
+    const Vec3 ap = access_.GetPosition(a);
+    const Vec3 pp = access_.GetPosition(player_);
+    const float dx = ap.x - pp.x;
+    const float dy = ap.y - pp.y;
+    const float r2 = static_cast<float>(r) * static_cast<float>(r);
+    return (dx * dx + dy * dy) <= r2;  // XY-Radius
+}
+
+bool SpeedCore::Gather(ActorRef a, ActorInputs& in) { return Gather(a, in, true); }
+
+ArmorWeight SpeedCore::ArmorOf(ActorRef a) {
+    const auto s = actors_.Find(a.formID);
+    if (s == ActorStateTable::kNoSlot) {
+        ++caseStats_.armorReads;
+        return access_.GetArmorWeight(a);
+    }
+
+    auto& c = actors_.armorCache[s];
+    if (!c.valid) {
+        const ArmorWeight w = access_.GetArmorWeight(a);
+        c.sum = w.sum;
+        c.max = w.max;
+        c.valid = true;
+        ++caseStats_.armorReads;
+    }
+    return ArmorWeight{c.sum, c.max};
+}
+
+bool SpeedCore::BeastForm(ActorRef a) {
+    const auto s = actors_.Find(a.formID);
+    if (s == ActorStateTable::kNoSlot) {
+        ++caseStats_.beastChecks;
+        return access_.IsInBeastForm(a);
+    }
+
+    auto& c = actors_.raceCache[s];
+    const void* race = access_.GetRace(a);
+    if (!c.valid || c.race != race || c.epoch != settings_->epoch) {
+        c.race = race;
+        c.epoch = settings_->epoch;
+        c.beast = access_.IsInBeastForm(a);
+        c.valid = true;
+        ++caseStats_.beastChecks;
+    }
+    return c.beast;
+}
+
+bool SpeedCore::Gather(ActorRef a, ActorInputs& in, bool checkRange) {
+    in = ActorInputs{};
+    in.nowMs = access_.NowMs();
+    in.pos = access_.GetPosition(a);
+
+    if (const auto s = actors_.Find(a.formID); s != ActorStateTable::kNoSlot && actors_.armorCache[s].equipPending) {
+        actors_.armorCache[s].equipPending = false;
+        MarkDirty(a, kDirtyArmor);
+        in.equipChanged = true;
+    }
+
+    const bool isPlayer = a.IsPlayer();
+    if (settings_->ignoreBeastForms) in.beast = BeastForm(a);
+    in.inRange = isPlayer || !checkRange || InRadius(in.pos);
+    if (in.beast || !in.inRange) return false;
+
+    in.sprinting = access_.IsSprinting(a);
+    in.sneaking = access_.IsSneaking(a);
+    in.drawn = access_.IsWeaponDrawn(a);
+    in.combat = access_.IsInCombat(a);
+    in.speedMult = access_.GetActorValue(a, ActorStat::SpeedMult);
+    in.scale = SanitizeScale(access_.GetScale(a));
+
+    if (isPlayer) {
+        in.moveX = moveX;
+        in.moveY = moveY;
+    } else {
+        (void)access_.GetMoveAxes(a, in.moveX, in.moveY);
+    }
+
+    if (settings_->healthEnabled) {
+        in.health = access_.GetActorValue(a, ActorStat::Health);
+        in.healthMax = access_.GetPermanentActorValue(a, ActorStat::Health);
+    }
+    if (settings_->staminaEnabled) {
+        in.stamina = access_.GetActorValue(a, ActorStat::Stamina);
+        in.staminaMax = access_.GetPermanentActorValue(a, ActorStat::Stamina);
+    }
+    if (settings_->magickaEnabled) {
+        in.magicka = access_.GetActorValue(a, ActorStat::Magicka);
+        in.magickaMax = access_.GetPermanentActorValue(a, ActorStat::Magicka);
+    }
+
+    // Armor only changes on equip (kDirtyArmor), the location modifier only with the location
+    const auto slot = actors_.Find(a.formID);
+    if (settings_->armorAffectsMovement) {
+        if (CaseCached(slot, kDirtyArmor)) {
+            in.armorCached = true;
+        } else {
+            in.armor = ArmorOf(a);
+        }
+    }
+
+    const bool wantLoc = settings_->locationMode != Settings::LocationMode::Ignore;
+    const bool wantWeather = settings_->weatherEnabled;
+    if (wantLoc || wantWeather) {
+        in.place = access_.GetPlace(a);
+        if (wantLoc) {
+            if (CaseCached(slot, kDirtyPlace) && actors_.caseCache[slot].location == in.place.location) {
+                in.locationMod = actors_.caseCache[slot].locMod;
+                in.hasLocationMod = (actors_.caseCache[slot].key & kKeyHasLocation) != 0;
+            } else {
+                ++caseStats_.locationLookups;
+                if (auto v = access_.GetLocationModifier(in.place)) {
+                    in.locationMod = *v;
+                    in.hasLocationMod = true;
+                }
+            }
+        }
+        if (wantWeather) {
+            if (const auto& w = weatherMod_[in.place.interior ? 1 : 0]) {
+                in.weatherMod = *w;
+                in.hasWeatherMod = true;
+            }
+        }
+    }
+    return true;
+}
+
+SpeedCore::MoveCase SpeedCore::ComputeCase(const ActorInputs& in) const {
+    CaseSettings k;
+    k.noReductionInCombat = settings_->noReductionInCombat;
+    return CaseOf(k, in);
+}
+
+SpeedCore::MoveCase SpeedCore::CaseOf(const CaseSettings& k, const ActorInputs& in) {
+    if (k.noReductionInCombat && in.combat) {
+        return MoveCase::Combat;
+    }
+    if (in.sneaking) {
+        return MoveCase::Sneak;
+    }
+    if (in.drawn) {
+        return MoveCase::Drawn;
+    }
+    return MoveCase::Default;
+}
+
+SpeedCore::CaseSettings SpeedCore::CaseSettings::Read(const Settings::Snapshot& c) {
+    CaseSettings k;
+    k.reduceOutOfCombat = c.reduceOutOfCombat;
+    k.reduceJogging = c.reduceJoggingOutOfCombat;
+    k.reduceDrawn = c.reduceDrawn;
+    k.reduceSneak = c.reduceSneak;
+    k.increaseSprinting = c.increaseSprinting;
+    k.noReductionInCombat = c.noReductionInCombat;
+    k.sprintAffectsCombat = c.sprintAffectsCombat;
+    k.locationMode = c.locationMode;
+    k.locationAffects = c.locationAffects;
+    k.weather = c.weatherEnabled;
+    k.weatherAffects = c.weatherAffects;
+    k.weatherMode = c.weatherMode;
+    k.armor = c.armorAffectsMovement;
+    k.useMaxArmorWeight = c.useMaxArmorWeight;
+    k.armorSlope = c.armorWeightSlopeSM;
+    k.armorPivot = c.armorWeightPivot;
+    k.armorMin = c.armorMoveMin;
+    k.armorMax = c.armorMoveMax;
+    k.health = {c.healthEnabled, c.healthThresholdPct, c.healthReducePct,
+                c.healthSmoothWidthPct};
+    k.stamina = {c.staminaEnabled, c.staminaThresholdPct,
+                 c.staminaReducePct, c.staminaSmoothWidthPct};
+    k.magicka = {c.magickaEnabled, c.magickaThresholdPct,
+                 c.magickaReducePct, c.magickaSmoothWidthPct};
+    k.scaleAdditive =
+        c.scaleCompEnabled && c.scaleCompMode == Settings::ScaleCompMode::Additive;
+    k.scaleOnlyBelowOne = c.scaleCompOnlyBelowOne;
+    k.scalePerUnit = c.scaleCompPerUnitSM;
+    k.formRules = c.rules->revision;
+    return k;
+}
+
+void SpeedCore::SyncSettings() {
+    settings_ = Settings::Current();
+    moveFilter_.SyncMovement(*settings_);
+    SyncCaseSettings();
+}
+
+void SpeedCore::SyncCaseSettings() {
+    const auto k = CaseSettings::Read(*settings_);
+    if (caseEpoch_ == 0 || !(k == caseSettings_)) {
+        caseSettings_ = k;
+        if (++caseEpoch_ == 0) caseEpoch_ = 1;  // 0 marks a slot that was never built
+    }
+}
+
+void SpeedCore::ResolveWeather() {
+    for (int i = 0; i < 2; ++i) {
+        weatherMod_[i] = settings_->weatherEnabled ? access_.GetWeatherModifier(ActorPlace{nullptr, nullptr, i == 1})
+                                                   : std::nullopt;
+    }
+}
+
+float SpeedCore::StatePart(const CaseSettings& k, const ActorInputs& in) const {
+    const MoveCase c = CaseOf(k, in);
+    float base = 0.0f;
+    switch (c) {
+        case MoveCase::Combat:
+            base = 0.0f;
+            break;
+        case MoveCase::Drawn:
+            base = -k.reduceDrawn;
+            break;
+        case MoveCase::Sneak:
+            base = -k.reduceSneak;
+            break;
+        default:
+            base = -(joggingMode ? k.reduceJogging : k.reduceOutOfCombat);
+            break;
+    }
+
+    if (k.locationMode != Settings::LocationMode::Ignore &&
+        (k.locationAffects == Settings::LocationAffects::AllStates ||
+         (k.locationAffects == Settings::LocationAffects::DefaultOnly && (c == MoveCase::Default)))) {
+        if (in.hasLocationMod) {
+            base = (k.locationMode == Settings::LocationMode::Replace) ? -in.locationMod : base - in.locationMod;
+        }
+    }
+
+    if (k.weather && (k.weatherAffects == Settings::WeatherAffects::AllStates ||
+                      (k.weatherAffects == Settings::WeatherAffects::DefaultOnly && (c == MoveCase::Default)))) {
+        if (in.hasWeatherMod) {
+            base = (k.weatherMode == Settings::WeatherMode::Replace) ? -in.weatherMod : base - in.weatherMod;
+        }
+    }
+
+    if (in.sprinting) {
+        if (c != MoveCase::Combat || k.sprintAffectsCombat) {
+            base += k.increaseSprinting;
+        }
+    }
+    return base;
+}
+
+float SpeedCore::ArmorPart(const CaseSettings& k, const ArmorWeight& armor) {
+    if (!k.armor) return 0.0f;
+    return MovementMath::ArmorMoveDelta(k.useMaxArmorWeight ? armor.max : armor.sum, k.armorSlope, k.armorPivot,
+                                        k.armorMin, k.armorMax);
+}
+
+float SpeedCore::VitalsPart(const CaseSettings& k, const ActorInputs& in) {
+    const auto penalty = [](const CaseSettings::Vital& v, float cur, float maxv) {
+        return v.on ? MovementMath::LinearVitalPenaltyPct(cur, maxv, v.threshold, v.reduce, v.width) : 0.0f;
+    };
+    float vit = 0.0f;
+    vit += penalty(k.health, in.health, in.healthMax);
+    vit += penalty(k.stamina, in.stamina, in.staminaMax);
+    vit += penalty(k.magicka, in.magicka, in.magickaMax);
+    return vit;
+}
+
+float SpeedCore::ScalePart(const CaseSettings& k, float scale) {
+    if (!k.scaleAdditive || (k.scaleOnlyBelowOne && scale >= 1.0f)) return 0.0f;
+    return k.scalePerUnit * (1.0f - scale);
+}
+
+std::uint8_t SpeedCore::StateKey(const ActorInputs& in) const {
+    return static_cast<std::uint8_t>((in.combat ? kKeyCombat : 0) | (in.sneaking ? kKeySneak : 0) |
+                                     (in.drawn ? kKeyDrawn : 0) | (in.sprinting ? kKeySprint : 0) |
+                                     (joggingMode ? kKeyJogging : 0) | (in.hasLocationMod ? kKeyHasLocation : 0) |
+                                     (in.hasWeatherMod ? kKeyHasWeather : 0));
+}
+
+// Sum in the same order as MovementTarget, so cached and uncached targets are bit-identical
+float SpeedCore::CaseToDelta(const ActorInputs& in) const {
+    DSC_PROFILE_SCOPE(Diag::Stage::CaseToDelta);
+    const auto k = CaseSettings::Read(*settings_);
+    float base = StatePart(k, in);
+    base += ArmorPart(k, in.armor);
+    base += VitalsPart(k, in);
+    base += ScalePart(k, in.scale);
+    return base;
+}
+
+float SpeedCore::MovementTarget(ActorStateTable::Slot s, const ActorInputs& in) {
+    DSC_PROFILE_SCOPE(Diag::Stage::CaseToDelta);
+    auto& c = actors_.caseCache[s];
+    const auto& k = caseSettings_;
+    ++caseStats_.targets;
+
+    std::uint8_t dirty = (c.epoch == caseEpoch_) ? c.dirty : kDirtyAll;
+
+    // Probes for everything without an event: compare against the inputs the cache was built from
+    const std::uint8_t key = StateKey(in);
+    if (key != c.key || in.locationMod != c.locMod || in.weatherMod != c.weatherMod) dirty |= kDirtyState;
+    const std::array<float, 6> vit{in.health, in.healthMax, in.stamina, in.staminaMax, in.magicka, in.magickaMax};
+    if (vit != c.vitalsIn) dirty |= kDirtyVitals;
+    if (in.scale != c.scaleIn) dirty |= kDirtyScale;
+
+    if (dirty & kDirtyState) {
+        c.state = StatePart(k, in);
+        c.key = key;
+        c.locMod = in.locationMod;
+        c.weatherMod = in.weatherMod;
+        ++caseStats_.rebuilt[0];
+    }
+    c.location = in.place.location;
+    // A fresh armor read always rebuilds. A cached one never can, a mark that arrived after the gather stays set.
+    if (!in.armorCached && (k.armor || (dirty & kDirtyArmor))) {
+        c.armor = ArmorPart(k, in.armor);
+        ++caseStats_.rebuilt[1];
+    }
+    if (dirty & kDirtyVitals) {
+        c.vitals = VitalsPart(k, in);
+        c.vitalsIn = vit;
+        ++caseStats_.rebuilt[2];
+    }
+    if (dirty & kDirtyScale) {
+        c.scale = ScalePart(k, in.scale);
+        c.scaleIn = in.scale;
+        ++caseStats_.rebuilt[3];
+    }
+    c.dirty = in.armorCached ? (dirty & kDirtyArmor) : 0;
+    c.epoch = caseEpoch_;
+
+    float base = c.state;
+    base += c.armor;
+    base += c.vitals;
+    base += c.scale;
+    return base;
+}
+
+void SpeedCore::ApplyFor(ActorRef a) {
+    if (!a) return;
+    if (player_ && !a.IsPlayer()) playerPos_ = access_.GetPosition(player_);
+
+    ActorInputs in;
+    Gather(a, in);
+    ApplyFor(a, in);
+}
+
+void SpeedCore::ApplyFor(ActorRef a, ActorInputs& in) {
+    if (!a) return;
+    DSC_PROFILE_SCOPE(Diag::Stage::ApplyFor);
+
+    BeginBatch(in);
+
+    if (in.beast) {
+        RevertDeltasFor(a, &in);
+        CommitBatch(a, in);
+        return;
+    }
+
+    const bool isPlayer = a.IsPlayer();
+    if (!in.inRange) {
+        if (actors_.Find(a.formID) == ActorStateTable::kNoSlot) return;  // nothing of ours on it
+        RevertDeltasFor(a, &in);
+        CommitBatch(a, in);
+        ClearNPCState(a.formID);
+        return;
+    }
+
+    const auto slot = SlotOf(a);
+    float want = 0.0f;
+    if (in.pre.valid) {
+        want = in.pre.want;
+    } else {
+        want = MovementTarget(slot, in);
+        if (!isPlayer) want *= NPCPercent(*settings_);
+    }
+
+    float& cur = actors_.moveDelta[slot];
+    const float dt = StepDt(slot, in.nowMs);
+    actors_.lastApplyMs[slot] = in.nowMs;
+
+    bool smoothing = settings_->smoothingEnabled && (isPlayer || settings_->smoothingAffectsNPCs);
+
+    // Flip-Logic: Always invalidate diagonal penalty
+    auto& pS = actors_.prevSprinting[slot];
+    auto& pN = actors_.prevSneak[slot];
+    auto& pD = actors_.prevDrawn[slot];
+    const bool flip = (in.sprinting != static_cast<bool>(pS)) || (in.sneaking != static_cast<bool>(pN)) ||
+                      (in.drawn != static_cast<bool>(pD));
+    pS = in.sprinting;
+    pN = in.sneaking;
+    pD = in.drawn;
+    actors_.prevCombat[slot] = in.combat;
+
+    if (flip || in.sprinting || std::fabs(in.moveX) > 1e-3f || std::fabs(in.moveY) > 1e-3f) active_ = true;
+
+    if (flip) {
+        // immediately reject Diagonal-Delta, so Headroom/Clamp fits exactly
+        ClearDiagDeltaFor(a, &in);
+        if (settings_->smoothingBypassOnStateChange && smoothing) {
+            smoothing = false;
+            RevertMovementDeltasFor(a, false, &in);
+        }
+        Refresh(a, &in);
+    }
+
+    float newDelta = want;
+    if (smoothing) {
+        newDelta = in.pre.valid ? in.pre.smoothed : moveFilter_.Step(cur, want, dt);
+    }
+    const float diagF = in.pre.valid ? in.pre.diagFactor : MovementMath::DiagonalFactor(in.moveX, in.moveY);
+
+    float diff = newDelta - cur;
+
+    const bool wantDiag = !in.reduced && (isPlayer ? settings_->enableDiagonalSpeedFix
+                                                   : settings_->enableDiagonalSpeedFixForNPCs);
+
+    {
+        const float floor = settings_->minFinalSpeedMult;
+
+        const float curSlot = actors_.moveDelta[slot];
+        const float diagSlot = actors_.diagDelta[slot];
+        const float slopeSlot = actors_.slopeDelta[slot];
+
+        const float baseNoUs = in.speedMult - curSlot - diagSlot - slopeSlot;
+
+        float predictedDiag = 0.0f;
+        if (wantDiag) {
+            predictedDiag = MovementMath::PredictDiagonalPenalty(baseNoUs + newDelta, floor, diagF, in.sprinting);
+        }
+
+        float expectedNoScaleFinal = baseNoUs + newDelta + predictedDiag + slopeSlot;
+
+        float sFactor = 1.0f;
+        if (settings_->scaleCompEnabled && settings_->scaleCompMode == Settings::ScaleCompMode::Inverse) {
+            if (!settings_->scaleCompOnlyBelowOne || in.scale < 1.0f) sFactor = 1.0f / in.scale;
+        }
+
+        float expectedFinal = expectedNoScaleFinal * sFactor;
+
+        if (settings_->slopeClampEnabled) {
+            const float lo = settings_->slopeMinFinal;
+            const float hi = settings_->slopeMaxFinal;
+            if (expectedFinal < lo) {
+                newDelta += (lo - expectedFinal);
+                expectedFinal = lo;
+            } else if (expectedFinal > hi) {
+                newDelta -= (expectedFinal - hi);
+                expectedFinal = hi;
+            }
+        }
+
+        if (expectedFinal < floor) {
+            const float needed = floor - expectedFinal;
+            newDelta += needed;
+            expectedNoScaleFinal += needed;
+            expectedFinal = expectedNoScaleFinal * sFactor;
+        }
+
+        diff = newDelta - curSlot;
+    }
+
+    bool moveChanged = false;
+    if (std::fabs(diff) > 0.0001f) {
+        ModSpeedMult(a, &in, diff);
+        cur = newDelta;
+        moveChanged = true;
+    }
+
+    bool diagChanged = false;
+    if (wantDiag) {
+        diagChanged = UpdateDiagonalPenalty(a, in, diagF);
+    } else {
+        ClearDiagDeltaFor(a, &in);
+    }
+
+    // Reduced tiers: the slope needs a dense path history, drop it. The scale delta is static, keep it.
+    bool slopeChanged = false;
+    if (in.reduced) {
+        ClearSlopeDeltaFor(a, &in);
+    } else {
+        slopeChanged = UpdateSlopePenalty(a, in, dt);
+    }
+
+    bool scaleChanged = false;
+    const bool inverseScale =
+        settings_->scaleCompEnabled && settings_->scaleCompMode == Settings::ScaleCompMode::Inverse;
+    if (inverseScale && !in.reduced) {
+        const float floor = settings_->minFinalSpeedMult;
+
+        const float curSlot2 = actors_.moveDelta[slot];
+        const float diagSlot2 = actors_.diagDelta[slot];
+        const float slopeSlot2 = actors_.slopeDelta[slot];
+
+        const float baseNoUs2 = in.speedMult - curSlot2 - diagSlot2 - slopeSlot2;
+        const float predictedDiag2 =
+            MovementMath::PredictDiagonalPenalty(baseNoUs2 + curSlot2, floor, diagF, in.sprinting);
+        const float noScaleFinalPreview = baseNoUs2 + curSlot2 + predictedDiag2 + slopeSlot2;
+
+        scaleChanged = UpdateScaleCompDelta(a, in, noScaleFinalPreview);
+    } else if (!inverseScale) {
+        ClearScaleDeltaFor(a, &in);
+    }
+
+    if (isPlayer) {
+        if (slopeChanged) {
+            access_.RequestRefresh(a);
+        }
+    } else {
+        if (moveChanged || diagChanged || slopeChanged || scaleChanged) {
+            Refresh(a, &in);
+        }
+    }
+
+    ClampSpeedFloorTracked(a, in);
+    CommitBatch(a, in);
+
+    // The player's runs every heartbeat anyway
+    if (in.equipChanged && !isPlayer) UpdateAttackSpeed(a);
+}
+
+void SpeedCore::CommitBatch(ActorRef a, ActorInputs& in) {
+    in.batching = false;
+    if (in.pendingWrites > 0) {
+        // Exact zero only, the ledger slots assume every component landed
+        if (in.pendingSpeedMult != 0.0f) {
+            access_.ModActorValue(a, ActorStat::SpeedMult, in.pendingSpeedMult);
+            ++stats_.engineWrites;
+        } else {
+            ++stats_.cancelledCommits;
+        }
+        in.pendingWrites = 0;
+        in.pendingSpeedMult = 0.0f;
+    }
+    if (in.refreshWanted) {
+        in.refreshWanted = false;
+        QueueRefresh(a);
+    }
+}
+
+void SpeedCore::QueueRefresh(ActorRef a) {
+    if (!a) return;
+    ++refreshStats_.requested;
+    const auto s = actors_.Find(a.formID);
+    if (s != ActorStateTable::kNoSlot) {
+        auto& st = actors_.refreshState[s];
+        if (st == ActorStateTable::kRefreshQueued) {
+            ++refreshStats_.coalesced;
+            return;
+        }
+        st = ActorStateTable::kRefreshQueued;
+    }
+    refreshQueue_.push_back(a);
+}
+
+void SpeedCore::FlushRefreshes(std::span<const ActorRef> npcs) {
+    if (refreshOwed_) {
+        // Owed by an earlier flush. Only handles of this tick are safe to use, so an event flush (no span) pays the
+        // player and leaves the NPCs to the next tick's.
+        if (!npcs.empty()) refreshOwed_ = false;
+        auto requeue = [&](ActorRef a) {
+            const auto s = actors_.Find(a.formID);
+            if (s == ActorStateTable::kNoSlot || actors_.refreshState[s] != ActorStateTable::kRefreshOwed) return;
+            actors_.refreshState[s] = ActorStateTable::kRefreshQueued;
+            refreshQueue_.push_back(a);
+        };
+        if (player_) requeue(player_);
+        for (const auto& a : npcs) {
+            if (a && !a.IsPlayer()) requeue(a);
+        }
+    }
+    if (refreshQueue_.empty()) return;
+
+    const std::uint64_t now = access_.NowMs();
+    auto due = [&](ActorRef a, std::uint64_t last) {
+        const int minMs = a.IsPlayer() ? settings_->refreshMinIntervalMs : settings_->npcRefreshMinIntervalMs;
+        return last == 0 || now - last >= static_cast<std::uint64_t>(minMs);
+    };
+
+    for (const auto& a : refreshQueue_) {
+        const auto s = actors_.Find(a.formID);
+        if (s == ActorStateTable::kNoSlot) {
+            // Released after it was queued (reverted, out of range). This is the refresh that takes the vanilla
+            // SpeedMult into the movement speed and there is no slot left to owe it on, so it is never throttled.
+            if (access_.ForceSpeedRefresh(a)) ++refreshStats_.executed;
+            continue;
+        }
+
+        auto& st = actors_.refreshState[s];
+        std::uint64_t& last = actors_.lastRefreshMs[s];
+        if (!due(a, last)) {
+            st = ActorStateTable::kRefreshOwed;
+            ++refreshStats_.throttled;
+            refreshOwed_ = true;
+            active_ = true;  // stay on the active cadence until it is paid
+            continue;
+        }
+
+        st = 0;
+        if (access_.ForceSpeedRefresh(a)) {
+            last = now;
+            ++refreshStats_.executed;
+        }
+    }
+    refreshQueue_.clear();
+}
+
+bool SpeedCore::UpdateDiagonalPenalty(ActorRef a) {
+    if (!a) return false;
+    if (player_ && !a.IsPlayer()) playerPos_ = access_.GetPosition(player_);
+
+    ActorInputs in;
+    if (!Gather(a, in)) return false;
+    return UpdateDiagonalPenalty(a, in, MovementMath::DiagonalFactor(in.moveX, in.moveY));
+}
+
+bool SpeedCore::UpdateDiagonalPenalty(ActorRef a, ActorInputs& in, float f) {
+    DSC_PROFILE_SCOPE(Diag::Stage::DiagonalPenalty);
+    const auto s = SlotOf(a);
+    float& slot = actors_.diagDelta[s];
+
+    const float floor = settings_->minFinalSpeedMult;
+
+    const float curNoDiag = in.speedMult - slot;
+    float headroom = std::max(0.0f, curNoDiag - floor);
+
+    float newDiag = 0.0f;
+    if (f < 0.999f) {
+        newDiag = headroom * (f - 1.0f);  // <= 0
+        if (in.sprinting) newDiag *= 0.5f;
+    } else {
+        newDiag = 0.0f;
+    }
+
+    const float delta = newDiag - slot;
+
+    float& acc = actors_.diagResidual[s];
+    acc += delta;
+
+    static constexpr float kDiagGran = 5e-4f;
+    if (std::fabs(acc) >= kDiagGran) {
+        ModSpeedMult(a, &in, acc);
+        slot += acc;
+        acc = 0.0f;
+        return true;
+    }
+    return false;
+}
+
+void SpeedCore::PushPathSample(ActorStateTable::Slot s, const Vec3& pos, std::uint64_t nowMs) {
+    const float histSec = std::max(0.f, settings_->slopeMaxHistorySec);
+    const std::uint64_t maxAgeMs = static_cast<std::uint64_t>(histSec * 1000.f);
+
+    // One sample per heartbeat at most, sized with headroom for faster event-driven ticks
+    const auto wantCap = static_cast<std::uint32_t>(
+        std::clamp<std::uint64_t>(maxAgeMs / kPathSampleMinIntervalMs + 2, 4, kPathRingMaxCapacity));
+
+    auto& q = actors_.path[s];
+    if (q.capacity() < wantCap || q.capacity() >= wantCap * 4) {
+        q.Reset(wantCap);
+    }
+
+    float sxy = 0.0f;
+    if (!q.empty()) {
+        const auto& last = q.back();
+        const float dx = pos.x - last.x;
+        const float dy = pos.y - last.y;
+        const float dxy = std::sqrt(dx * dx + dy * dy);
+        if (dxy < settings_->slopeMinXYPerFrame) {
+            sxy = last.sxy;
+        } else {
+            sxy = last.sxy + dxy;
+        }
+    }
+    q.push_back(PathSample{pos.x, pos.y, pos.z, sxy, nowMs});
+
+    while (!q.empty() && (nowMs - q.front().tMs) > maxAgeMs) {
+        q.pop_front();
+    }
+}
+
+void SpeedCore::PublishSweat(ActorRef a, ActorStateTable::Slot s, std::uint64_t nowMs) {
+    auto& st = actors_.sweat[s];
+    constexpr float kEps = 1e-3f;
+    if (st.intensity <= kEps) {
+        ClearSweat(a, s);
+        return;
+    }
+    if (st.outstanding && std::fabs(st.intensity - st.sent) <= kSweatStep && nowMs - st.sentMs < kSweatResendMs) {
+        return;
+    }
+    access_.PublishSweat(a, st.intensity);
+    st.sent = st.intensity;
+    st.sentMs = nowMs;
+    st.outstanding = true;
+}
+
+void SpeedCore::ClearSweat(ActorRef a, ActorStateTable::Slot s) {
+    auto& st = actors_.sweat[s];
+    if (!st.outstanding) return;
+    access_.ClearSweat(a);
+    st.sent = 0.0f;
+    st.outstanding = false;
+}
+
+bool SpeedCore::UpdateSlopePenalty(ActorRef a, ActorInputs& in, float dt) {
+    if (!a || !SlopeActive(*settings_, a.IsPlayer(), dt)) return false;
+    DSC_PROFILE_SCOPE(Diag::Stage::SlopePenalty);
+
+    const auto s = SlotOf(a);
+    if (!in.pre.pathPushed) PushPathSample(s, in.pos, in.nowMs);
+
+    float slopeDeg = 0.0f;
+    bool haveSlope = false;
+
+    bool still = false;
+
+    const auto& q = actors_.path[s];
+    if (q.size() >= 2) {
+        const float movedXY = q.back().sxy - q[q.size() - 2].sxy;
+        still = (std::fabs(movedXY) < settings_->slopeMinXYPerFrame);
+    }
+
+    if (settings_->slopeMethod == 1) {
+        if (in.pre.pathPushed) {
+            haveSlope = in.pre.haveSlope;
+            slopeDeg = in.pre.slopeDeg;
+        } else {
+            haveSlope = MovementMath::ComputePathSlopeDeg(q, settings_->slopeLookbackUnits, slopeDeg);
+        }
+        if (a.IsPlayer() && settings_->dwEnabled && settings_->dwSlopeFeatureEnabled) {
+            const float startDeg = std::max(0.0f, settings_->dwStartDeg);
+            const float fullDeg = std::max(startDeg + 0.1f, settings_->dwFullDeg);
+            const float span = std::max(0.1f, fullDeg - startDeg);
+
+            float target = 0.0f;
+
+            if (!still && haveSlope && slopeDeg > startDeg) {
+                const float moveMag = std::clamp(std::sqrt(in.moveX * in.moveX + in.moveY * in.moveY), 0.0f, 1.0f);
+                const float slopePart = std::clamp((slopeDeg - startDeg) / span, 0.0f, 1.0f);
+                target = std::clamp(slopePart * (0.50f + 0.50f * moveMag), 0.0f, 1.0f);
+            }
+
+            const float rateUp = std::max(0.0f, settings_->dwBuildUpPerSec);
+            const float rateDown = std::max(0.0f, settings_->dwDryPerSec);
+            float& intensity = actors_.sweat[s].intensity;
+            const float rate = (target >= intensity) ? rateUp : rateDown;
+
+            intensity = MovementMath::RateTowards(intensity, target, dt, rate);
+            PublishSweat(a, s, in.nowMs);
+        } else {
+            ClearSweat(a, s);
+        }
+    }
+
+    float want = 0.0f;
+    if (settings_->slopeMethod == 1) {
+        if (!still) {
+            if (haveSlope) {
+                if (slopeDeg > 0.0f)
+                    want -= settings_->slopeUphillPerDeg * slopeDeg;
+                else if (slopeDeg < 0.0f)
+                    want += settings_->slopeDownhillPerDeg * (-slopeDeg);
+                want = std::clamp(want, -settings_->slopeMaxAbs, settings_->slopeMaxAbs);
+            }
+        }
+    }
+
+    float& slot = actors_.slopeDelta[s];
+    const float tau = std::max(0.01f, settings_->slopeTau);
+    const float alpha = 1.0f - std::exp(-dt / tau);
+    const float newDelta = slot + alpha * (want - slot);
+
+    float diff = newDelta - slot;
+    float& acc = actors_.slopeResidual[s];
+    acc += diff;
+
+    static constexpr float kSlopeGran = 1e-4f;
+    if (std::fabs(acc) >= kSlopeGran) {
+        ModSpeedMult(a, &in, acc);
+        slot += acc;
+        acc = 0.0f;
+        return true;
+    }
+    return false;
+}
+
+bool SpeedCore::UpdateScaleCompDelta(ActorRef a, ActorInputs& in, float predictedNoScaleFinal) {
+    if (!settings_->scaleCompEnabled) {
+        ClearScaleDeltaFor(a, &in);
+        return false;
+    }
+    if (settings_->scaleCompMode != Settings::ScaleCompMode::Inverse) {
+        ClearScaleDeltaFor(a, &in);
+        return false;
+    }
+
+    const float sc = in.scale;
+    if (settings_->scaleCompOnlyBelowOne && sc >= 1.0f) {
+        // No inverse correction above 1.0
+        ClearScaleDeltaFor(a, &in);
+        return false;
+    }
+    const float factor = 1.0f / std::max(0.01f, sc);
+    const float K = factor - 1.0f;
+
+    const auto s = SlotOf(a);
+    float& slot = actors_.scaleDelta[s];
+    const float target = K * predictedNoScaleFinal;  // make final = noScale * factor
+    const float delta = target - slot;
+
+    float& acc = actors_.scaleResidual[s];
+    acc += delta;
+
+    static constexpr float kGran = 5e-4f;
+    if (std::fabs(acc) >= kGran) {
+        ModSpeedMult(a, &in, acc);
+        slot += acc;
+        acc = 0.0f;
+        return true;
+    }
+    return false;
+}
+
+void SpeedCore::UpdateAttackSpeed(ActorRef a) {
+    if (!a) return;
+    DSC_PROFILE_SCOPE(Diag::Stage::AttackSpeed);
+
+    const auto s = SlotOf(a);
+    auto& c = actors_.attackCache[s];
+    float& myDelta = actors_.attackDelta[s];
+
+    AttackCache::Inputs next;
+    next.epoch = settings_->epoch;
+    next.active = settings_->attackSpeedEnabled && !(settings_->ignoreBeastForms && BeastForm(a)) &&
+                  !(settings_->attackOnlyWhenDrawn && !access_.IsWeaponDrawn(a));
+    if (next.active) {
+        if (!c.weaponValid) {
+            c.weapon = access_.GetEquippedWeight(a);
+            c.weaponValid = true;
+        }
+        next.weapon = c.weapon;
+        if (settings_->usePlayerScale) next.scale = SanitizeScale(access_.GetScale(a));
+        if (settings_->armorAffectsAttackSpeed) {
+            const ArmorWeight aw = ArmorOf(a);
+            next.armor = settings_->useMaxArmorWeight ? aw.max : aw.sum;
+        }
+    }
+    if (c.valid && next == c.in) return;
+
+    MovementMath::AttackParams p;
+    p.base = settings_->attackBase;
+    p.weightPivot = settings_->weightPivot;
+    p.weightSlope = settings_->weightSlope;
+    p.useScale = settings_->usePlayerScale;
+    p.scaleSlope = settings_->scaleSlope;
+    p.minMult = settings_->minAttackMult;
+    p.maxMult = settings_->maxAttackMult;
+    p.useArmor = settings_->armorAffectsAttackSpeed;
+    p.armorSlope = settings_->armorWeightSlopeAtk;
+    p.armorPivot = settings_->armorWeightPivot;
+
+    const float target = next.active ? MovementMath::AttackSpeedTarget(p, next.weapon, next.scale, next.armor) : 0.0f;
+    const bool sameTarget = c.valid && c.in.active && next.active && std::fabs(target - c.target) <= 1e-4f;
+    c.in = next;
+    c.target = target;
+    c.valid = true;
+    if (sameTarget) return;  // our delta still holds the engine value on it
+
+    if (std::fabs(myDelta) > 1e-6f) {
+        access_.ModActorValue(a, ActorStat::WeaponSpeedMult, -myDelta);
+        myDelta = 0.0f;
+    }
+    if (!next.active) return;
+
+    const float cur = access_.GetActorValue(a, ActorStat::WeaponSpeedMult);
+    const float delta = target - cur;
+
+    if (std::fabs(delta) > 1e-4f) {
+        access_.ModActorValue(a, ActorStat::WeaponSpeedMult, delta);
+        myDelta = delta;
+    }
+}
+
+void SpeedCore::ClearDiagDeltaFor(ActorRef a, ActorInputs* in) {
+    if (!a) return;
+    const auto s = SlotOf(a);
+    float& slot = actors_.diagDelta[s];
+    if (std::fabs(slot) > 1e-6f) {
+        ModSpeedMult(a, in, -slot);
+        slot = 0.0f;
+    }
+    actors_.diagResidual[s] = 0.0f;
+}
+
+bool SpeedCore::ClearSlopeDeltaFor(ActorRef a, ActorInputs* in) {
+    if (!a) return false;
+    const auto s = SlotOf(a);
+    float& slot = actors_.slopeDelta[s];
+    const bool wrote = std::fabs(slot) > 1e-4f;
+    if (wrote) {
+        ModSpeedMult(a, in, -slot);
+        slot = 0.0f;
+    }
+    actors_.slopeResidual[s] = 0.0f;
+    actors_.path[s].clear();
+    actors_.lastSlopeMs[s] = 0;
+    return wrote;
+}
+
+void SpeedCore::ClearScaleDeltaFor(ActorRef a, ActorInputs* in) {
+    if (!a) return;
+    const auto s = SlotOf(a);
+    float& slot = actors_.scaleDelta[s];
+    if (std::fabs(slot) > 1e-6f) {
+        ModSpeedMult(a, in, -slot);
+        slot = 0.0f;
+    }
+    actors_.scaleResidual[s] = 0.0f;
+}
+
+void SpeedCore::RevertMovementDeltasFor(ActorRef a, bool clearSlope, ActorInputs* in) {
+    if (!a) return;
+    const auto s = SlotOf(a);
+
+    bool wrote = false;
+
+    // Movement-Delta
+    float& moveDelta = actors_.moveDelta[s];
+    if (std::fabs(moveDelta) > 1e-6f) {
+        ModSpeedMult(a, in, -moveDelta);
+        moveDelta = 0.0f;
+        wrote = true;
+    }
+
+    // Diagonal-Delta
+    float& diag = actors_.diagDelta[s];
+    if (std::fabs(diag) > 1e-6f) {
+        ModSpeedMult(a, in, -diag);
+        diag = 0.0f;
+        wrote = true;
+    }
+
+    // Slope-Delta
+    if (clearSlope) {
+        wrote |= ClearSlopeDeltaFor(a, in);
+    }
+
+    if (wrote) Refresh(a, in);
+}
+
+void SpeedCore::RevertDeltasFor(ActorRef a, ActorInputs* in) {
+    if (!a) return;
+    const auto s = SlotOf(a);
+    bool wrote = false;  // SpeedMult only, the engine needs no refresh for kWeaponSpeedMult
+
+    float& moveDelta = actors_.moveDelta[s];
+    if (std::fabs(moveDelta) > 1e-6f) {
+        ModSpeedMult(a, in, -moveDelta);
+        moveDelta = 0.0f;
+        wrote = true;
+    }
+
+    float& atkDelta = actors_.attackDelta[s];
+    if (std::fabs(atkDelta) > 1e-6f) {
+        access_.ModActorValue(a, ActorStat::WeaponSpeedMult, -atkDelta);
+        atkDelta = 0.0f;
+    }
+    actors_.attackCache[s].valid = false;  // the next update writes again
+
+    float& diag = actors_.diagDelta[s];
+    if (std::fabs(diag) > 1e-6f) {
+        ModSpeedMult(a, in, -diag);
+        diag = 0.0f;
+        wrote = true;
+    }
+
+    float& sc = actors_.scaleDelta[s];
+    if (std::fabs(sc) > 1e-6f) {
+        ModSpeedMult(a, in, -sc);
+        sc = 0.0f;
+        wrote = true;
+    }
+
+    wrote |= ClearSlopeDeltaFor(a, in);
+    if (wrote) Refresh(a, in);
+
+    actors_.diagResidual[s] = 0.0f;
+    actors_.slopeResidual[s] = 0.0f;
+    actors_.scaleResidual[s] = 0.0f;
+}
+
+void SpeedCore::ClampSpeedFloorTracked(ActorRef a, ActorInputs& in) {
+    const float floor = settings_->minFinalSpeedMult;
+
+    const float eps = 1e-4f;
+    if (in.speedMult < floor - eps) {
+        const float need = floor - in.speedMult;
+        ModSpeedMult(a, &in, need);
+        actors_.moveDelta[SlotOf(a)] += need;
+    }
+}
+
+void SpeedCore::UpdateSlopeTickNPCsOnly(std::span<const ActorRef> npcs) {
+    if (!settings_->enableSpeedScalingForNPCs) return;
+
+    const std::size_t n = npcs.size();
+    if (n == 0) return;
+    if (slopeCursor_ >= n) slopeCursor_ = 0;
+
+    // Same chunks and budget as the full pass. Own cursor, the full pass's lap and staleness bound stay its own.
+    const auto start = Clock::now();
+    std::size_t processed = 0;
+    while (processed < n) {
+        const std::size_t chunk = std::min(kSliceChunk, n - processed);
+        for (std::size_t k = 0; k < chunk; ++k) SlopeTickNPC(npcs[(slopeCursor_ + processed + k) % n]);
+        processed += chunk;
+
+        if (processed < n && OverBudget(start, settings_->npcBudgetUs)) {
+            ++slice_.budgetStops;
+            break;
+        }
+    }
+    slopeCursor_ = (slopeCursor_ + processed) % n;
+}
+
+void SpeedCore::SlopeTickNPC(ActorRef a) {
+    if (!a || a.IsPlayer()) return;
+
+    // Slope-only pass, gathers just what the slope and the floor clamp read
+    ActorInputs in;
+    in.nowMs = access_.NowMs();
+    in.pos = access_.GetPosition(a);
+
+    if (settings_->npcLodEnabled) {
+        // Tiers are decided by the full tick, the slope only runs for near actors
+        const auto s = actors_.Find(a.formID);
+        if (s == ActorStateTable::kNoSlot || actors_.lodTier[s] != static_cast<std::uint8_t>(LodTier::Near)) {
+            return;
+        }
+    } else if (!InRadius(in.pos)) {
+        if (actors_.Find(a.formID) == ActorStateTable::kNoSlot) return;
+        RevertDeltasFor(a);
+        ClearNPCState(a.formID);
+        return;
+    }
+    in.speedMult = access_.GetActorValue(a, ActorStat::SpeedMult);
+    BeginBatch(in);
+
+    std::uint64_t& t = actors_.lastSlopeMs[SlotOf(a)];
+    float dt = (t == 0) ? (1.0f / 60.0f) : std::max(0.0f, (in.nowMs - t) / 1000.0f);
+    t = in.nowMs;
+
+    bool changed = UpdateSlopePenalty(a, in, dt);
+    if (changed) {
+        Refresh(a, &in);
+    }
+    ClampSpeedFloorTracked(a, in);
+    CommitBatch(a, in);
+}
+
+void SpeedCore::RevertNPC(ActorRef a) {
+    if (!a || a.IsPlayer()) return;
+
+    const auto s = actors_.Find(a.formID);
+    if (s == ActorStateTable::kNoSlot) return;
+
+    ActorInputs in;
+    BeginBatch(in);
+    bool wrote = false;
+
+    if (std::fabs(actors_.moveDelta[s]) > 0.001f) {
+        ModSpeedMult(a, &in, -actors_.moveDelta[s]);
+        actors_.moveDelta[s] = 0.0f;
+        wrote = true;
+    }
+    if (std::fabs(actors_.attackDelta[s]) > 1e-6f) {
+        access_.ModActorValue(a, ActorStat::WeaponSpeedMult, -actors_.attackDelta[s]);
+        actors_.attackDelta[s] = 0.0f;
+    }
+    actors_.attackCache[s].valid = false;
+    if (std::fabs(actors_.diagDelta[s]) > 0.001f) {
+        ModSpeedMult(a, &in, -actors_.diagDelta[s]);
+        actors_.diagDelta[s] = 0.0f;
+        wrote = true;
+    }
+    if (std::fabs(actors_.scaleDelta[s]) > 0.001f) {
+        ModSpeedMult(a, &in, -actors_.scaleDelta[s]);
+        actors_.scaleDelta[s] = 0.0f;
+        wrote = true;
+    }
+
+    if (ClearSlopeDeltaFor(a, &in)) wrote = true;
+    if (wrote) Refresh(a, &in);  // nothing of ours on SpeedMult, nothing to recompute
+    CommitBatch(a, in);
+}
+
+void SpeedCore::RevertAllNPCDeltas(std::span<const ActorRef> npcs) {
+    constexpr auto p = ActorStateTable::kPlayerSlot;
+
+    for (const auto& a : npcs) RevertNPC(a);
+
+    actors_.ReleaseAllNPCs();
+    actors_.diagResidual[p] = 0.0f;
+    actors_.slopeResidual[p] = 0.0f;
+    revertPending_ = false;
+}
+
+void SpeedCore::StepNPCRevert(std::span<const ActorRef> npcs) {
+    const auto start = Clock::now();
+    std::size_t done = 0;
+    while (revertCursor_ < npcs.size()) {
+        const auto& a = npcs[revertCursor_++];
+        if (!a || a.IsPlayer()) continue;
+        RevertNPC(a);
+        ClearNPCState(a.formID);
+        if ((++done % kSliceChunk) == 0 && OverBudget(start, settings_->npcBudgetUs)) return;
+    }
+
+    // Lap done, whatever is left in the table is not in the process list anymore
+    RevertAllNPCDeltas({});
+    revertCursor_ = 0;
+}
+
+void SpeedCore::ToggleJogging() {
+    if (!player_) return;
+
+    ActorInputs in;
+    if (!Gather(player_, in)) {
+        // Beast form: nothing of ours is applied, just remember the mode
+        joggingMode = !joggingMode;
+        return;
+    }
+    BeginBatch(in);
+
+    ClearDiagDeltaFor(player_, &in);
+
+    constexpr auto p = ActorStateTable::kPlayerSlot;
+    const float before = MovementTarget(p, in);
+    joggingMode = !joggingMode;
+    const float after = MovementTarget(p, in);
+    const float diff = after - before;
+
+    if (std::fabs(diff) > 0.01f) {
+        ModSpeedMult(player_, &in, diff);
+    }
+    actors_.moveDelta[p] = after;
+
+    if (settings_->enableDiagonalSpeedFix) {
+        UpdateDiagonalPenalty(player_, in, MovementMath::DiagonalFactor(in.moveX, in.moveY));
+    }
+    Refresh(player_, &in);
+    CommitBatch(player_, in);
+}
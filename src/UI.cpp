@@ -107,9 +107,12 @@ void UI::Register() {
     SKSEMenuFramework::AddSectionItem("Location Rules", SpeedConfig::RenderLocations);
     SKSEMenuFramework::AddSectionItem("Weather Presets", SpeedConfig::RenderWeather);
     SKSEMenuFramework::AddSectionItem("Add-ons", SpeedConfig::RenderAddons);
+    SKSEMenuFramework::AddSectionItem("Diagnostics", SpeedConfig::RenderDiagnostics);
 }
 
 void __stdcall UI::SpeedConfig::RenderGeneral() {
+    // The widgets below write the statics, the game thread's JSON load must not run in between
+    const auto lk = Settings::LockWrites();
     ImGui::Text("General Speed Modifiers");
 
     bool ignoreBeast = Settings::ignoreBeastForms.load();
@@ -146,6 +149,41 @@ void __stdcall UI::SpeedConfig::RenderGeneral() {
         }
         ImGui::TextDisabled("NPCs apply only this percent of the player's movement modifiers.");
         ImGui::TextDisabled("This is to account for NPCs being generally slower than players.");
+
+        bool lod = Settings::npcLodEnabled.load();
+        if (ImGui::Checkbox("Distance tiers", &lod)) {
+            Settings::npcLodEnabled.store(lod);
+        }
+        if (lod) {
+            int nearR = Settings::npcLodNearRadius.load();
+            if (ImGui::SliderInt("Near tier radius", &nearR, 0, 16384)) {
+                Settings::npcLodNearRadius.store(nearR);
+            }
+            int midR = Settings::npcLodMidRadius.load();
+            if (ImGui::SliderInt("Mid tier radius", &midR, 0, 16384)) {
+                Settings::npcLodMidRadius.store(midR);
+            }
+            int every = Settings::npcLodMidInterval.load();
+            if (ImGui::SliderInt("Mid tier: update every N ticks", &every, 1, 30)) {
+                Settings::npcLodMidInterval.store(every);
+            }
+            int hyst = Settings::npcLodHysteresis.load();
+            if (ImGui::SliderInt("Tier hysteresis", &hyst, 0, 1024)) {
+                Settings::npcLodHysteresis.store(hyst);
+            }
+            ImGui::TextDisabled("Near: full update. Mid: movement case only.");
+            ImGui::TextDisabled("Far (up to NPC Radius): only on sprint/sneak/drawn/combat changes.");
+        }
+
+        int budget = Settings::npcBudgetUs.load();
+        if (ImGui::SliderInt("NPC time budget per tick (us, 0 = none)", &budget, 0, 10000)) {
+            Settings::npcBudgetUs.store(budget);
+        }
+        int stale = Settings::npcMaxStaleMs.load();
+        if (ImGui::SliderInt("Max NPC update delay (ms)", &stale, 33, 2000)) {
+            Settings::npcMaxStaleMs.store(stale);
+        }
+        ImGui::TextDisabled("NPCs that do not fit into the budget continue next tick, in turn.");
     }
     FontAwesome::Pop();
 
@@ -168,6 +206,20 @@ void __stdcall UI::SpeedConfig::RenderGeneral() {
             }
         }
 
+        float dz = Settings::inputDeadzone.load();
+        if (ImGui::SliderFloat("Stick Deadzone", &dz, 0.0f, 0.9f, "%.2f")) {
+            Settings::inputDeadzone.store(dz);
+        }
+        bool radial = Settings::inputRadialDeadzone.load();
+        if (ImGui::Checkbox("Radial Deadzone", &radial)) {
+            Settings::inputRadialDeadzone.store(radial);
+        }
+        float step = Settings::inputAxisStep.load();
+        if (ImGui::SliderFloat("Stick Axis Step", &step, 0.0f, 0.5f, "%.2f")) {
+            Settings::inputAxisStep.store(step);
+        }
+        ImGui::TextDisabled("Rounds stick axes to this step so small stick noise causes no SpeedMult writes (0 = off).");
+
         bool scEn = Settings::scaleCompEnabled.load();
         if (ImGui::Checkbox("Actor Scale Compensation (movement)", &scEn)) {
             Settings::scaleCompEnabled.store(scEn);
@@ -203,6 +255,22 @@ void __stdcall UI::SpeedConfig::RenderGeneral() {
             Settings::eventDebounceMs.store(eventDebounceMs);
         }
 
+        int idleMs = Settings::heartbeatIdleMs.load();
+        if (ImGui::SliderInt("Idle Heartbeat (ms)", &idleMs, 0, 1000)) {
+            Settings::heartbeatIdleMs.store(idleMs);
+        }
+        ImGui::TextDisabled("Update interval once nothing moves or converges. 33 or less = always full rate.");
+
+        int refreshMs = Settings::refreshMinIntervalMs.load();
+        if (ImGui::SliderInt("Min Refresh Interval (ms)", &refreshMs, 0, 500)) {
+            Settings::refreshMinIntervalMs.store(refreshMs);
+        }
+        int npcRefreshMs = Settings::npcRefreshMinIntervalMs.load();
+        if (ImGui::SliderInt("Min NPC Refresh Interval (ms)", &npcRefreshMs, 0, 500)) {
+            Settings::npcRefreshMinIntervalMs.store(npcRefreshMs);
+        }
+        ImGui::TextDisabled("Speed changes closer together than this are picked up by one engine refresh.");
+
         bool smooth = Settings::smoothingEnabled.load();
         if (ImGui::Checkbox("Enable smoothing", &smooth)) {
             Settings::smoothingEnabled.store(smooth);
@@ -248,9 +316,12 @@ void __stdcall UI::SpeedConfig::RenderGeneral() {
         }
     }
     FontAwesome::Pop();
+    // Widgets write the Settings statics, the controller only sees them once published
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::Render() {
+    const auto lk = Settings::LockWrites();
     FontAwesome::PushSolid();
     if (ImGui::CollapsingHeader(movementSpeedHeader.c_str())) {
         float minFinalSpeedMult = Settings::minFinalSpeedMult.load();
@@ -518,6 +589,18 @@ void __stdcall UI::SpeedConfig::Render() {
             Settings::toggleSpeedKey.store(sc);
             SpeedController::GetSingleton()->UpdateBindingsFromSettings();
         }
+
+        // Follows the setting while not being edited, a load can replace it
+        static char chordBuf[128] = {};
+        static bool chordEditing = false;
+        if (!chordEditing) std::snprintf(chordBuf, sizeof(chordBuf), "%s", Settings::toggleSpeedChords.c_str());
+        if (ImGui::InputText("Toggle Chords", chordBuf, sizeof(chordBuf))) {
+            Settings::toggleSpeedChords = chordBuf;
+            SpeedController::GetSingleton()->UpdateBindingsFromSettings();
+        }
+        chordEditing = ImGui::IsItemActive();
+        ImGui::TextDisabled("Extra toggle keys, comma separated. Chord keys joined by '+', held keys first (42+19).");
+        ImGui::TextDisabled("Custom event names can be lists too (Shout, Sneak).");
     }
     FontAwesome::Pop();
 
@@ -529,9 +612,11 @@ void __stdcall UI::SpeedConfig::Render() {
         }
     }
     FontAwesome::Pop();
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::RenderAttack() {
+    const auto lk = Settings::LockWrites();
     ImGui::Text("Attack Speed");
     ImGui::Separator();
 
@@ -589,9 +674,11 @@ void __stdcall UI::SpeedConfig::RenderAttack() {
         }
     }
     FontAwesome::Pop();
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::RenderVitals() {
+    const auto lk = Settings::LockWrites();
     FontAwesome::PushSolid();
     if (ImGui::CollapsingHeader(vitalsHeader.c_str())) {
         ImGui::TextDisabled("SpeedMult reduction when vital resources are low. Values are in SpeedMult points (%%).");
@@ -654,9 +741,11 @@ void __stdcall UI::SpeedConfig::RenderVitals() {
         FontAwesome::Pop();
     }
     FontAwesome::Pop();
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::RenderLocations() {
+    const auto lk = Settings::LockWrites();
     ImGui::Text("Location-based Modifiers");
     ImGui::Separator();
 
@@ -710,6 +799,7 @@ void __stdcall UI::SpeedConfig::RenderLocations() {
             if (Settings::ParseFormSpec(specBuf, fs.plugin, fs.id)) {
                 fs.value = std::max(0.f, std::min(100.f, specVal));
                 Settings::reduceInLocationSpecific.push_back(std::move(fs));
+                Settings::MarkFormRulesChanged();
                 specBuf[0] = '\0';
             }
         }
@@ -730,9 +820,12 @@ void __stdcall UI::SpeedConfig::RenderLocations() {
                 if (ImGui::DragFloat(("##specv" + std::to_string(i)).c_str(), &v, 0.1f, 0.f, 100.f, "%.1f")) {
                     fs.value = std::max(0.f, std::min(100.f, v));
                 }
+                // Once per drag, every new revision rebuilds the whole location table
+                if (ImGui::IsItemDeactivatedAfterEdit()) Settings::MarkFormRulesChanged();
                 ImGui::TableSetColumnIndex(2);
                 if (ImGui::SmallButton(("X##spec" + std::to_string(i)).c_str())) {
                     Settings::reduceInLocationSpecific.erase(Settings::reduceInLocationSpecific.begin() + i);
+                    Settings::MarkFormRulesChanged();
                     --i;
                 }
             }
@@ -791,6 +884,7 @@ void __stdcall UI::SpeedConfig::RenderLocations() {
                 fs.value = std::max(0.f, std::min(100.f, typeVal));
                 if (!alreadyInList(fs)) {
                     Settings::reduceInLocationType.push_back(std::move(fs));
+                    Settings::MarkFormRulesChanged();
                 }
                 typeBuf[0] = '\0';
             }
@@ -812,9 +906,11 @@ void __stdcall UI::SpeedConfig::RenderLocations() {
                 if (ImGui::DragFloat(("##typev" + std::to_string(i)).c_str(), &v, 0.1f, 0.f, 100.f, "%.1f")) {
                     fs.value = std::max(0.f, std::min(100.f, v));
                 }
+                if (ImGui::IsItemDeactivatedAfterEdit()) Settings::MarkFormRulesChanged();
                 ImGui::TableSetColumnIndex(2);
                 if (ImGui::SmallButton(("X##type" + std::to_string(i)).c_str())) {
                     Settings::reduceInLocationType.erase(Settings::reduceInLocationType.begin() + i);
+                    Settings::MarkFormRulesChanged();
                     --i;
                 }
             }
@@ -832,9 +928,11 @@ void __stdcall UI::SpeedConfig::RenderLocations() {
         }
     }
     FontAwesome::Pop();
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::RenderWeather() {
+    const auto lk = Settings::LockWrites();
     ImGui::Text("Weather-based Modifiers");
     ImGui::Separator();
 
@@ -904,6 +1002,7 @@ void __stdcall UI::SpeedConfig::RenderWeather() {
                 }
             }
             if (!replaced) Settings::reduceInWeatherSpecific.push_back(std::move(fs));
+            Settings::MarkFormRulesChanged();
             specBuf[0] = '\0';
         }
     }
@@ -974,6 +1073,9 @@ void __stdcall UI::SpeedConfig::RenderWeather() {
                                 Settings::reduceInWeatherSpecific.push_back(std::move(fs));
                             }
                         }
+                    }
+                    if (ImGui::IsItemDeactivatedAfterEdit()) {
+                        Settings::MarkFormRulesChanged();
                         if (auto* pc = RE::PlayerCharacter::GetSingleton())
                             SpeedController::GetSingleton()->RefreshNow();
                     }
@@ -984,6 +1086,7 @@ void __stdcall UI::SpeedConfig::RenderWeather() {
                     if (idx >= 0) {
                         if (ImGui::SmallButton(idRem.c_str())) {
                             Settings::reduceInWeatherSpecific.erase(Settings::reduceInWeatherSpecific.begin() + idx);
+                            Settings::MarkFormRulesChanged();
                         }
                     } else {
                         ImGui::BeginDisabled();
@@ -1008,9 +1111,11 @@ void __stdcall UI::SpeedConfig::RenderWeather() {
         }
     }
     FontAwesome::Pop();
+    Settings::Publish();
 }
 
 void __stdcall UI::SpeedConfig::RenderAddons() {
+    const auto lk = Settings::LockWrites();
     ImGui::Text("Add-ons");
     ImGui::Separator();
 
@@ -1075,4 +1180,80 @@ void __stdcall UI::SpeedConfig::RenderAddons() {
         }
     }
     FontAwesome::Pop();
+    Settings::Publish();
+}
+
+void __stdcall UI::SpeedConfig::RenderDiagnostics() {
+    ImGui::Text("Diagnostics");
+    ImGui::Separator();
+
+#if DSC_DIAGNOSTICS
+    const Diag::Snapshot snap = Diag::Take();
+
+    FontAwesome::PushSolid();
+    if (ImGui::Button(resetIcon.c_str())) {
+        Diag::Reset();
+    }
+    FontAwesome::Pop();
+    ImGui::SameLine();
+    ImGui::TextDisabled("%.1f s since reset. Per-actor stages time 1 in 16 calls.", snap.seconds);
+
+    if (ImGui::BeginTable("diagStages", 7, ImGuiTableFlags_Resizable | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Calls/s");
+        ImGui::TableSetupColumn("p50 (us)");
+        ImGui::TableSetupColumn("p95 (us)");
+        ImGui::TableSetupColumn("p99 (us)");
+        ImGui::TableSetupColumn("Max (us)");
+        ImGui::TableHeadersRow();
+
+        for (std::size_t i = 0; i < Diag::kStageCount; ++i) {
+            const auto& st = snap.stages[i];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(Diag::StageName(static_cast<Diag::Stage>(i)));
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%llu", static_cast<unsigned long long>(st.calls));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.1f", st.perSec);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.2f", st.p50Us);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.2f", st.p95Us);
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%.2f", st.p99Us);
+            ImGui::TableSetColumnIndex(6);
+            ImGui::Text("%.2f", st.maxUs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Separator();
+    for (std::size_t i = 0; i < Diag::kCounterCount; ++i) {
+        const auto& c = snap.counters[i];
+        ImGui::Text("%s: %llu (%.1f/s)", Diag::CounterName(static_cast<Diag::Counter>(i)),
+                    static_cast<unsigned long long>(c.total), c.perSec);
+    }
+#else
+    ImGui::TextDisabled("This build was compiled without diagnostics (DSC_DIAGNOSTICS=0).");
+#endif
+
+    ImGui::Separator();
+    // Copy published by the heartbeat, the core's own counters belong to the game thread
+    const auto stats = SpeedController::GetSingleton()->Core().PublishedStats();
+    if (!stats) return;
+    const auto& ws = stats->writes;
+    ImGui::Text("SpeedMult writes: %llu components -> %llu engine writes",
+                static_cast<unsigned long long>(ws.componentWrites), static_cast<unsigned long long>(ws.engineWrites));
+    const auto& lod = stats->lod;
+    ImGui::Text("NPC tiers (last tick): near %u, mid %u, far %u, out %u, updated %u", lod.tier[0], lod.tier[1],
+                lod.tier[2], lod.tier[3], lod.updated);
+    const auto& sl = stats->slice;
+    ImGui::Text("NPC slicing: %u of %u per tick, lap %llu ms, budget stops %llu", sl.processed, sl.total,
+                static_cast<unsigned long long>(sl.roundTripMs), static_cast<unsigned long long>(sl.budgetStops));
+    const auto& rf = stats->refreshes;
+    ImGui::Text("Speed refreshes: %llu requested, %llu coalesced, %llu throttled, %llu executed",
+                static_cast<unsigned long long>(rf.requested), static_cast<unsigned long long>(rf.coalesced),
+                static_cast<unsigned long long>(rf.throttled), static_cast<unsigned long long>(rf.executed));
 }
\ No newline at end of file
@@ -0,0 +1,628 @@
+// Micro-benchmarks for the MovementMath kernels.
+// Every kernel runs over a batch of synthetic actors (chained state, so nothing gets hoisted out of the loop),
+// sweeping actor counts, path history lengths and smoothing modes. One result row per combination, as CSV or JSON.
+//
+// batch_* rows time the BatchMath kernels once per available instruction set. Before any timing, every BatchMath
+// kernel is checked against its scalar reference over the in-game input ranges (tolerances in BatchMath.h), a
+// kernel outside its bound fails the run with exit code 1. --check runs only that and prints one row per kernel.
+//
+//   DSCBench [--actors 1,64,512,4096] [--history 16,64,256,1024] [--reps N] [--min-ms N] [--filter text]
+//            [--format csv|json] [--seed N] [--check]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ActorStateTable.h"
+#include "BatchMath.h"
+#include "MovementMath.h"
+#include "Settings.h"
+
+namespace {
+    using SM = Settings::SmoothingMode;
+
+    struct Options {
+        std::vector<std::size_t> actors{1, 64, 512, 4096};
+        std::vector<std::size_t> history{16, 64, 256, 1024};
+        int reps = 5;
+        int minMs = 20;  // per rep
+        std::string filter;
+        bool json = false;
+        std::uint32_t seed = 1;
+        bool checkOnly = false;
+    };
+
+    // Path rings get big quickly (24 bytes per sample), combinations above this are skipped
+    constexpr std::size_t kMaxPathSamples = std::size_t{1} << 21;
+
+    constexpr float kDt = 0.033f;
+
+    std::vector<std::size_t> ParseList(const char* v) {
+        std::vector<std::size_t> out;
+        for (const char* p = v; *p;) {
+            char* end = nullptr;
+            const auto n = std::strtoull(p, &end, 10);
+            if (end == p) break;
+            if (n > 0) out.push_back(static_cast<std::size_t>(n));
+            p = (*end == ',') ? end + 1 : end;
+        }
+        return out;
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const char* k = argv[i];
+            if (!std::strcmp(k, "--check")) {
+                o.checkOnly = true;
+                continue;
+            }
+            const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (!v) {
+                std::fprintf(stderr, "missing value for %s\n", k);
+                return false;
+            }
+            if (!std::strcmp(k, "--actors"))
+                o.actors = ParseList(v);
+            else if (!std::strcmp(k, "--history"))
+                o.history = ParseList(v);
+            else if (!std::strcmp(k, "--reps"))
+                o.reps = std::max(1, std::atoi(v));
+            else if (!std::strcmp(k, "--min-ms"))
+                o.minMs = std::max(1, std::atoi(v));
+            else if (!std::strcmp(k, "--filter"))
+                o.filter = v;
+            else if (!std::strcmp(k, "--format"))
+                o.json = !std::strcmp(v, "json");
+            else if (!std::strcmp(k, "--seed"))
+                o.seed = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+            else {
+                std::fprintf(stderr, "unknown option %s\n", k);
+                return false;
+            }
+            ++i;
+        }
+        if (o.actors.empty() || o.history.empty()) {
+            std::fprintf(stderr, "empty --actors / --history list\n");
+            return false;
+        }
+        return true;
+    }
+
+    const char* ModeName(SM m) {
+        switch (m) {
+            case SM::Exponential:
+                return "expo";
+            case SM::RateLimit:
+                return "rate";
+            case SM::ExpoThenRate:
+                return "expo_rate";
+        }
+        return "?";
+    }
+
+    // Per-actor inputs, regenerated for every actor count
+    struct Batch {
+        std::vector<float> prev, target;
+        std::vector<float> inX, inY, curSM;
+        std::vector<float> vital, vitalMax;
+        std::vector<float> weight, scale, armor;
+        std::vector<std::uint8_t> sprinting;
+
+        Batch(std::size_t n, std::mt19937& rng) {
+            std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+            auto fill = [&](std::vector<float>& v, float lo, float hi) {
+                v.resize(n);
+                for (auto& x : v) x = lo + (hi - lo) * u01(rng);
+            };
+            fill(prev, -40.0f, 40.0f);
+            fill(target, -40.0f, 40.0f);
+            fill(inX, -1.0f, 1.0f);
+            fill(inY, -1.0f, 1.0f);
+            fill(curSM, 60.0f, 160.0f);
+            fill(vital, 0.0f, 300.0f);
+            fill(vitalMax, 100.0f, 300.0f);
+            fill(weight, 0.0f, 40.0f);
+            fill(scale, 0.8f, 1.2f);
+            fill(armor, 0.0f, 60.0f);
+            sprinting.resize(n);
+            for (auto& s : sprinting) s = u01(rng) < 0.3f;
+        }
+
+        // Targets drift between passes, so the smoothers never settle
+        void Retarget(std::size_t pass) {
+            const float f = (pass & 1) ? 1.0f : -1.0f;
+            for (auto& t : target) t = -t * 0.9f + f;
+        }
+    };
+
+    struct Result {
+        std::string kernel;
+        std::string mode;
+        std::size_t actors = 0;
+        std::size_t history = 0;  // 0 = not applicable
+        std::uint64_t passes = 0;
+        double nsMedian = 0.0;  // per actor
+        double nsMin = 0.0;
+        double checksum = 0.0;
+    };
+
+    class Runner {
+    public:
+        explicit Runner(const Options& o) : opt_(o) {}
+
+        bool Wanted(const std::string& kernel) const {
+            return opt_.filter.empty() || kernel.find(opt_.filter) != std::string::npos;
+        }
+
+        // pass(i) runs the kernel once over all actors and returns a checksum
+        void Measure(const std::string& kernel, const std::string& mode, std::size_t actors, std::size_t history,
+                     const std::function<float(std::size_t)>& pass) {
+            using Clock = std::chrono::steady_clock;
+
+            // Calibrate: enough passes per rep to fill minMs
+            std::uint64_t passes = 1;
+            for (;;) {
+                const auto t0 = Clock::now();
+                for (std::uint64_t i = 0; i < passes; ++i) sink_ += pass(i);
+                const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                if (ms >= opt_.minMs * 0.25 || passes >= (std::uint64_t{1} << 30)) {
+                    if (ms > 0.0)
+                        passes = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(passes * opt_.minMs / ms));
+                    break;
+                }
+                passes *= 4;
+            }
+
+            std::vector<double> ns;
+            double checksum = 0.0;
+            for (int r = 0; r < opt_.reps; ++r) {
+                checksum = 0.0;
+                const auto t0 = Clock::now();
+                for (std::uint64_t i = 0; i < passes; ++i) checksum += pass(i);
+                const auto dt = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+                ns.push_back(dt / (static_cast<double>(passes) * static_cast<double>(actors)));
+            }
+            sink_ += static_cast<float>(checksum);
+            std::sort(ns.begin(), ns.end());
+
+            Result res;
+            res.kernel = kernel;
+            res.mode = mode;
+            res.actors = actors;
+            res.history = history;
+            res.passes = passes;
+            res.nsMedian = ns[ns.size() / 2];
+            res.nsMin = ns.front();
+            res.checksum = checksum;
+            results_.push_back(std::move(res));
+        }
+
+        void Print() const {
+            if (opt_.json) {
+                std::printf("{\n  \"meta\": {\"compiler\": \"%s\", \"diagnostics\": %d, \"reps\": %d, \"min_ms\": %d, "
+                            "\"seed\": %u, \"isa\": \"%s\"},\n  \"results\": [\n",
+                            Compiler(), DSC_DIAGNOSTICS, opt_.reps, opt_.minMs, opt_.seed,
+                            BatchMath::IsaName(BatchMath::ActiveIsa()));
+                for (std::size_t i = 0; i < results_.size(); ++i) {
+                    const auto& r = results_[i];
+                    std::printf("    {\"kernel\": \"%s\", \"mode\": \"%s\", \"actors\": %zu, \"history\": %zu, "
+                                "\"passes\": %llu, \"ns_per_actor_median\": %.3f, \"ns_per_actor_min\": %.3f, "
+                                "\"checksum\": %.6g}%s\n",
+                                r.kernel.c_str(), r.mode.c_str(), r.actors, r.history,
+                                static_cast<unsigned long long>(r.passes), r.nsMedian, r.nsMin, r.checksum,
+                                (i + 1 < results_.size()) ? "," : "");
+                }
+                std::printf("  ]\n}\n");
+                return;
+            }
+
+            std::printf("kernel,mode,actors,history,passes,ns_per_actor_median,ns_per_actor_min,checksum\n");
+            for (const auto& r : results_) {
+                std::printf("%s,%s,%zu,%zu,%llu,%.3f,%.3f,%.6g\n", r.kernel.c_str(), r.mode.c_str(), r.actors,
+                            r.history, static_cast<unsigned long long>(r.passes), r.nsMedian, r.nsMin, r.checksum);
+            }
+        }
+
+        float Sink() const { return sink_; }
+
+    private:
+        static const char* Compiler() {
+#if defined(__clang__)
+            return "clang " __clang_version__;
+#elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+            return "msvc";
+#else
+            return "unknown";
+#endif
+        }
+
+        const Options& opt_;
+        std::vector<Result> results_;
+        float sink_ = 0.0f;
+    };
+
+    void BenchSmoothing(Runner& run, Batch& b, std::size_t n) {
+        const float halfLifeMs = 120.0f;
+        const float maxPerSec = 200.0f;
+
+        if (run.Wanted("smooth_expo")) {
+            run.Measure("smooth_expo", "-", n, 0, [&](std::size_t pass) {
+                b.Retarget(pass);
+                float acc = 0.0f;
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += b.prev[i] = MovementMath::SmoothExpo(b.prev[i], b.target[i], kDt, halfLifeMs);
+                return acc;
+            });
+        }
+        if (run.Wanted("smooth_rate")) {
+            run.Measure("smooth_rate", "-", n, 0, [&](std::size_t pass) {
+                b.Retarget(pass);
+                float acc = 0.0f;
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += b.prev[i] = MovementMath::SmoothRate(b.prev[i], b.target[i], kDt, maxPerSec);
+                return acc;
+            });
+        }
+        if (run.Wanted("smooth_combined")) {
+            for (SM mode : {SM::Exponential, SM::RateLimit, SM::ExpoThenRate}) {
+                run.Measure("smooth_combined", ModeName(mode), n, 0, [&](std::size_t pass) {
+                    b.Retarget(pass);
+                    float acc = 0.0f;
+                    for (std::size_t i = 0; i < n; ++i)
+                        acc += b.prev[i] =
+                            MovementMath::SmoothCombined(b.prev[i], b.target[i], kDt, mode, halfLifeMs, maxPerSec);
+                    return acc;
+                });
+            }
+        }
+        if (run.Wanted("filter_policy")) {
+            // Same math as smooth_combined, but the policy is built once and the mode dispatch is outside the loop
+            for (SM mode : {SM::Exponential, SM::RateLimit, SM::ExpoThenRate}) {
+                const auto filter = MovementMath::SmoothingFilter::Movement(mode, halfLifeMs, maxPerSec);
+                run.Measure("filter_policy", ModeName(mode), n, 0, [&](std::size_t pass) {
+                    b.Retarget(pass);
+                    return filter.Visit([&](const auto& p) {
+                        float acc = 0.0f;
+                        for (std::size_t i = 0; i < n; ++i) acc += b.prev[i] = p.Step(b.prev[i], b.target[i], kDt);
+                        return acc;
+                    });
+                });
+            }
+        }
+        if (run.Wanted("expo_lerp")) {
+            run.Measure("expo_lerp", "-", n, 0, [&](std::size_t pass) {
+                b.Retarget(pass);
+                float acc = 0.0f;
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += b.prev[i] = MovementMath::ExpoLerp(b.prev[i], b.target[i], kDt, 0.1f);
+                return acc;
+            });
+        }
+        if (run.Wanted("rate_towards")) {
+            run.Measure("rate_towards", "-", n, 0, [&](std::size_t pass) {
+                b.Retarget(pass);
+                float acc = 0.0f;
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += b.prev[i] = MovementMath::RateTowards(b.prev[i], b.target[i], kDt, 5.0f);
+                return acc;
+            });
+        }
+        if (run.Wanted("smooth_sprint_anim")) {
+            // "none" = sprintAnimOwnSmoothing off, the other modes go through a published snapshot like in game
+            const bool ownSmoothing = Settings::sprintAnimOwnSmoothing.load();
+            const int prevMode = Settings::sprintAnimSmoothingMode.load();
+            for (int m = -1; m <= static_cast<int>(SM::ExpoThenRate); ++m) {
+                Settings::sprintAnimOwnSmoothing.store(m >= 0);
+                if (m >= 0) Settings::sprintAnimSmoothingMode.store(m);
+                Settings::Publish();
+                const auto cfg = Settings::Current();
+                run.Measure("smooth_sprint_anim", m < 0 ? "none" : ModeName(static_cast<SM>(m)), n, 0,
+                            [&](std::size_t pass) {
+                                b.Retarget(pass);
+                                float acc = 0.0f;
+                                for (std::size_t i = 0; i < n; ++i) {
+                                    acc += b.prev[i] =
+                                        MovementMath::SmoothSprintAnim(*cfg, b.prev[i], b.target[i], kDt);
+                                }
+                                return acc;
+                            });
+            }
+            Settings::sprintAnimOwnSmoothing.store(ownSmoothing);
+            Settings::sprintAnimSmoothingMode.store(prevMode);
+            Settings::Publish();
+        }
+    }
+
+    void BenchPenalties(Runner& run, Batch& b, std::size_t n) {
+        if (run.Wanted("predict_diagonal")) {
+            run.Measure("predict_diagonal", "-", n, 0, [&](std::size_t pass) {
+                float acc = 0.0f;
+                const float bias = static_cast<float>(pass & 7) * 0.01f;
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += MovementMath::PredictDiagonalPenalty(b.curSM[i], 30.0f, b.inX[i] + bias, b.inY[i],
+                                                                b.sprinting[i] != 0);
+                return acc;
+            });
+        }
+        if (run.Wanted("vital_penalty")) {
+            run.Measure("vital_penalty", "-", n, 0, [&](std::size_t pass) {
+                float acc = 0.0f;
+                const float thr = 25.0f + static_cast<float>(pass & 7);
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += MovementMath::LinearVitalPenaltyPct(b.vital[i], b.vitalMax[i], thr, 20.0f, 10.0f);
+                return acc;
+            });
+        }
+        if (run.Wanted("armor_move_delta")) {
+            run.Measure("armor_move_delta", "-", n, 0, [&](std::size_t pass) {
+                float acc = 0.0f;
+                const float pivot = 20.0f + static_cast<float>(pass & 7);
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += MovementMath::ArmorMoveDelta(b.armor[i], -0.5f, pivot, -20.0f, 10.0f);
+                return acc;
+            });
+        }
+        if (run.Wanted("attack_speed_target")) {
+            for (bool full : {false, true}) {
+                MovementMath::AttackParams p;
+                p.useScale = full;
+                p.useArmor = full;
+                run.Measure("attack_speed_target", full ? "scale_armor" : "weight", n, 0, [&, p](std::size_t pass) {
+                    float acc = 0.0f;
+                    const float bias = static_cast<float>(pass & 7) * 0.1f;
+                    for (std::size_t i = 0; i < n; ++i)
+                        acc += MovementMath::AttackSpeedTarget(p, b.weight[i] + bias, b.scale[i], b.armor[i]);
+                    return acc;
+                });
+            }
+        }
+    }
+
+    // One ring per actor, filled along a hilly walk, queried with varying lookback distances
+    void BenchPathSlope(Runner& run, std::size_t n, std::size_t history, std::mt19937& rng) {
+        if (!run.Wanted("path_slope")) return;
+        if (n * history > kMaxPathSamples) {
+            std::fprintf(stderr, "skip path_slope actors=%zu history=%zu (over %zu samples)\n", n, history,
+                         kMaxPathSamples);
+            return;
+        }
+
+        std::uniform_real_distribution<float> step(4.0f, 12.0f);
+        std::vector<PathRing> rings(n);
+        for (auto& r : rings) {
+            r.Reset(static_cast<std::uint32_t>(history));
+            float x = 0.0f, sxy = 0.0f;
+            for (std::size_t k = 0; k < history; ++k) {
+                const float d = step(rng);
+                x += d;
+                sxy += d;
+                r.push_back(PathSample{x, 0.0f, 120.0f * std::sin(x * 0.004f), sxy, k * 16});
+            }
+        }
+
+        const float lookbacks[] = {64.0f, 128.0f, 256.0f, 512.0f};
+        run.Measure("path_slope", "-", n, history, [&](std::size_t pass) {
+            float acc = 0.0f;
+            const float lookback = lookbacks[pass & 3];
+            for (const auto& r : rings) {
+                float deg = 0.0f;
+                if (MovementMath::ComputePathSlopeDeg(r, lookback, deg)) acc += deg;
+            }
+            return acc;
+        });
+    }
+
+    // BatchMath kernels per instruction set, mode column is "<mode>/<isa>"
+    void BenchBatch(Runner& run, Batch& b, std::size_t n, std::mt19937& rng) {
+        if (!run.Wanted("batch_smooth_combined") && !run.Wanted("batch_diagonal") && !run.Wanted("batch_slope")) return;
+
+        std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+        std::vector<float> dt(n, kDt), out(n), dz(n), dxy(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            dz[i] = (u01(rng) - 0.5f) * 100.0f;
+            dxy[i] = 1.0f + u01(rng) * 255.0f;
+        }
+
+        const auto best = BatchMath::ActiveIsa();
+        for (auto want : {BatchMath::Isa::Scalar, BatchMath::Isa::SSE2, BatchMath::Isa::AVX2}) {
+            const auto isa = BatchMath::ForceIsa(want);
+            if (isa != want) continue;
+            const std::string suffix = std::string("/") + BatchMath::IsaName(isa);
+
+            if (run.Wanted("batch_smooth_combined")) {
+                for (SM mode : {SM::Exponential, SM::RateLimit, SM::ExpoThenRate}) {
+                    const auto filter = MovementMath::SmoothingFilter::Movement(mode, 120.0f, 200.0f);
+                    run.Measure("batch_smooth_combined", ModeName(mode) + suffix, n, 0, [&](std::size_t pass) {
+                        b.Retarget(pass);
+                        BatchMath::Smooth(filter, b.prev.data(), b.target.data(), dt.data(), b.prev.data(), n);
+                        return b.prev[pass % n];
+                    });
+                }
+            }
+            if (run.Wanted("batch_diagonal")) {
+                run.Measure("batch_diagonal", "-" + suffix, n, 0, [&](std::size_t pass) {
+                    b.inX[pass % n] = -b.inX[pass % n];
+                    BatchMath::DiagonalFactor(b.inX.data(), b.inY.data(), out.data(), n);
+                    return out[pass % n];
+                });
+            }
+            if (run.Wanted("batch_slope")) {
+                run.Measure("batch_slope", "-" + suffix, n, 0, [&](std::size_t pass) {
+                    dz[pass % n] = -dz[pass % n];
+                    BatchMath::SlopeDeg(dz.data(), dxy.data(), out.data(), n);
+                    return out[pass % n];
+                });
+            }
+        }
+        BatchMath::ForceIsa(best);
+    }
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // Accuracy check: BatchMath kernels vs the scalar MovementMath reference
+    // ---------------------------------------------------------------------------------------------------------------
+    struct CheckRow {
+        std::string kernel;
+        std::string isa;
+        std::size_t samples = 0;
+        std::size_t failures = 0;
+        double worst = 0.0;  // Smooth: relative to |target - prev|, SlopeDeg: degrees, DiagonalFactor: absolute
+        double bound = 0.0;
+    };
+
+    // Odd length, so every ISA also runs its padded tail
+    constexpr std::size_t kCheckActors = 8191;
+
+    void CheckSmooth(std::vector<CheckRow>& rows, const std::string& isa, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+        std::vector<float> prev(kCheckActors), target(kCheckActors), dt(kCheckActors), out(kCheckActors);
+        for (std::size_t i = 0; i < kCheckActors; ++i) {
+            prev[i] = (u01(rng) - 0.5f) * 200.0f;
+            // Every 8th lane already sits on its target, those must come back unchanged
+            target[i] = (i % 8 == 0) ? prev[i] : (u01(rng) - 0.5f) * 200.0f;
+            // Mostly frame-sized steps, plus zero and the long gaps of the far LOD tiers
+            const float r = u01(rng);
+            dt[i] = (i % 16 == 1) ? 0.0f : (r < 0.8f ? r * 0.3125f : (r - 0.8f) * 50.0f);
+        }
+
+        for (SM mode : {SM::Exponential, SM::RateLimit, SM::ExpoThenRate}) {
+            // The UI slider ranges: half-life 1..2000 ms, max delta 1..300 per second
+            for (float halfLifeMs : {1.0f, 16.0f, 160.0f, 2000.0f}) {
+                for (float maxPerSec : {1.0f, 200.0f, 300.0f}) {
+                    const auto filter = MovementMath::SmoothingFilter::Movement(mode, halfLifeMs, maxPerSec);
+                    BatchMath::Smooth(filter, prev.data(), target.data(), dt.data(), out.data(), kCheckActors);
+
+                    CheckRow row{"batch_smooth_combined", ModeName(mode) + std::string("/") + isa};
+                    row.bound = BatchMath::kSmoothTolerance;
+                    for (std::size_t i = 0; i < kCheckActors; ++i) {
+                        const float ref = filter.Step(prev[i], target[i], dt[i]);
+                        const double err = std::fabs(static_cast<double>(out[i]) - ref);
+                        const double span = std::fabs(static_cast<double>(target[i]) - prev[i]);
+                        if (err > BatchMath::kSmoothTolerance * span || std::isnan(out[i])) ++row.failures;
+                        if (span > 0.0) row.worst = std::max(row.worst, err / span);
+                    }
+                    row.samples = kCheckActors;
+
+                    // One row per mode, merged over the parameter sweep
+                    auto it = std::find_if(rows.begin(), rows.end(), [&](const CheckRow& r) {
+                        return r.kernel == row.kernel && r.isa == row.isa;
+                    });
+                    if (it == rows.end()) {
+                        rows.push_back(row);
+                    } else {
+                        it->samples += row.samples;
+                        it->failures += row.failures;
+                        it->worst = std::max(it->worst, row.worst);
+                    }
+                }
+            }
+        }
+    }
+
+    void CheckDiagonal(std::vector<CheckRow>& rows, const std::string& isa, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+        std::vector<float> x(kCheckActors), y(kCheckActors), out(kCheckActors);
+        for (std::size_t i = 0; i < kCheckActors; ++i) {
+            x[i] = u01(rng) * 2.0f - 1.0f;
+            y[i] = u01(rng) * 2.0f - 1.0f;
+            // Idle sticks, single axes and the 1e-4 magnitude cut-off
+            if (i % 7 == 0) x[i] = 0.0f;
+            if (i % 11 == 0) y[i] = 0.0f;
+            if (i % 13 == 0) x[i] *= 1e-4f;
+        }
+        BatchMath::DiagonalFactor(x.data(), y.data(), out.data(), kCheckActors);
+
+        CheckRow row{"batch_diagonal", "-/" + isa, kCheckActors};
+        for (std::size_t i = 0; i < kCheckActors; ++i) {
+            const float ref = MovementMath::DiagonalFactor(x[i], y[i]);
+            if (out[i] != ref) ++row.failures;
+            row.worst = std::max(row.worst, std::fabs(static_cast<double>(out[i]) - ref));
+        }
+        rows.push_back(row);
+    }
+
+    void CheckSlope(std::vector<CheckRow>& rows, const std::string& isa, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+        std::vector<float> dz(kCheckActors), dxy(kCheckActors), out(kCheckActors);
+        for (std::size_t i = 0; i < kCheckActors; ++i) {
+            // dz/dxy log-uniform over 1e-4..1e4, so every atan range reduction branch and the +-85 clamp are hit
+            dxy[i] = 1.0f + u01(rng) * 1023.0f;
+            const float ratio = std::pow(10.0f, u01(rng) * 8.0f - 4.0f);
+            dz[i] = (i % 2 ? ratio : -ratio) * dxy[i];
+            if (i % 17 == 0) dz[i] = 0.0f;
+        }
+        BatchMath::SlopeDeg(dz.data(), dxy.data(), out.data(), kCheckActors);
+
+        CheckRow row{"batch_slope", "-/" + isa, kCheckActors};
+        row.bound = BatchMath::kSlopeToleranceDeg;
+        for (std::size_t i = 0; i < kCheckActors; ++i) {
+            const double err = std::fabs(static_cast<double>(out[i]) - MovementMath::SlopeDegFrom(dz[i], dxy[i]));
+            if (err > BatchMath::kSlopeToleranceDeg || std::isnan(out[i])) ++row.failures;
+            row.worst = std::max(row.worst, err);
+        }
+        rows.push_back(row);
+    }
+
+    // Runs every kernel on every available instruction set, true if all stay within their documented bound
+    bool CheckBatch(std::uint32_t seed, bool print) {
+        std::vector<CheckRow> rows;
+        const auto best = BatchMath::ActiveIsa();
+        for (auto want : {BatchMath::Isa::Scalar, BatchMath::Isa::SSE2, BatchMath::Isa::AVX2}) {
+            const auto isa = BatchMath::ForceIsa(want);
+            if (isa != want) continue;
+            // Same inputs for every ISA
+            std::mt19937 rng(seed);
+            CheckSmooth(rows, BatchMath::IsaName(isa), rng);
+            CheckDiagonal(rows, BatchMath::IsaName(isa), rng);
+            CheckSlope(rows, BatchMath::IsaName(isa), rng);
+        }
+        BatchMath::ForceIsa(best);
+
+        bool ok = true;
+        if (print) std::printf("kernel,mode,samples,failures,worst_err,bound,status\n");
+        for (const auto& r : rows) {
+            ok = ok && r.failures == 0;
+            if (!print && r.failures == 0) continue;
+            std::fprintf(print ? stdout : stderr, "%s,%s,%zu,%zu,%.3g,%.3g,%s\n", r.kernel.c_str(), r.isa.c_str(),
+                         r.samples, r.failures, r.worst, r.bound, r.failures ? "FAIL" : "ok");
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) return 2;
+
+    // A kernel that drifted from its scalar reference would shift in-game speeds, its timings are meaningless
+    if (!CheckBatch(opt.seed, opt.checkOnly)) {
+        std::fprintf(stderr, "BatchMath kernels outside their tolerance (see BatchMath.h)\n");
+        return 1;
+    }
+    if (opt.checkOnly) return 0;
+
+    std::mt19937 rng(opt.seed);
+    Runner run(opt);
+
+    for (std::size_t n : opt.actors) {
+        Batch b(n, rng);
+        BenchSmoothing(run, b, n);
+        BenchPenalties(run, b, n);
+        for (std::size_t h : opt.history) BenchPathSlope(run, n, h, rng);
+        BenchBatch(run, b, n, rng);
+    }
+
+    run.Print();
+    // Keeps the optimizer honest, never true in practice
+    if (std::isnan(run.Sink())) std::fprintf(stderr, "nan checksum\n");
+    return 0;
+}
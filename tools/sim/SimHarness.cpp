@@ -0,0 +1,357 @@
+// Headless simulation harness for SpeedCore.
+// Runs the real movement pipeline against synthetic actors (scripted movement, sneak, combat, slopes)
+// and reports the per-tick cost. No game, no CommonLibSSE.
+//
+//   DSCSim [--actors N] [--ticks N] [--seed N] [--dt-ms N] [--slope 0|1] [--diag 0|1] [--smoothing 0|1]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ActorAccess.h"
+#include "Settings.h"
+#include "SpeedCore.h"
+
+namespace {
+    struct SimActor {
+        std::uint32_t formID = 0;
+        Vec3 pos{};
+        float heading = 0.0f;
+        float speed = 0.0f;  // units per second at SpeedMult 100
+        float scale = 1.0f;
+        float moveX = 0.0f, moveY = 0.0f;
+
+        float speedMult = 100.0f;
+        float weaponSpeedMult = 1.0f;
+        float health = 100.0f, stamina = 100.0f, magicka = 100.0f;
+        float maxHealth = 100.0f, maxStamina = 100.0f, maxMagicka = 100.0f;
+
+        float equippedWeight = 0.0f;
+        ArmorWeight armor{};
+
+        bool sprinting = false, sneaking = false, combat = false, drawn = false;
+
+        // Script: state changes every few seconds
+        std::uint64_t nextFlipMs = 0;
+    };
+
+    // Rolling hills, gives the slope penalty something to chew on
+    float Height(float x, float y) { return 180.0f * std::sin(x * 0.0015f) + 120.0f * std::cos(y * 0.0021f); }
+
+    class SimWorld final : public ActorAccess {
+    public:
+        explicit SimWorld(std::uint32_t seed) : rng_(seed) {}
+
+        std::uint64_t NowMs() const override { return nowMs_; }
+
+        bool IsSprinting(ActorRef a) const override { return Get(a).sprinting; }
+        bool IsSneaking(ActorRef a) const override { return Get(a).sneaking; }
+        bool IsInCombat(ActorRef a) const override { return Get(a).combat; }
+        bool IsWeaponDrawn(ActorRef a) const override { return Get(a).drawn; }
+        bool IsInBeastForm(ActorRef) const override { return false; }
+        const void* GetRace(ActorRef) const override { return nullptr; }
+        bool GetMoveAxes(ActorRef a, float& outX, float& outY) const override {
+            const auto& s = Get(a);
+            outX = s.moveX;
+            outY = s.moveY;
+            return (std::fabs(outX) > 1e-4f) || (std::fabs(outY) > 1e-4f);
+        }
+        Vec3 GetPosition(ActorRef a) const override { return Get(a).pos; }
+        float GetScale(ActorRef a) const override { return Get(a).scale; }
+        float GetEquippedWeight(ActorRef a) const override { return Get(a).equippedWeight; }
+        ArmorWeight GetArmorWeight(ActorRef a) const override { return Get(a).armor; }
+        ActorPlace GetPlace(ActorRef) const override { return {}; }
+        std::optional<float> GetLocationModifier(const ActorPlace&) const override { return std::nullopt; }
+        std::optional<float> GetWeatherModifier(const ActorPlace&) const override { return std::nullopt; }
+
+        float GetActorValue(ActorRef a, ActorStat av) const override {
+            const auto& s = Get(a);
+            switch (av) {
+                case ActorStat::SpeedMult:
+                    return s.speedMult;
+                case ActorStat::WeaponSpeedMult:
+                    return s.weaponSpeedMult;
+                case ActorStat::Health:
+                    return s.health;
+                case ActorStat::Stamina:
+                    return s.stamina;
+                case ActorStat::Magicka:
+                    return s.magicka;
+            }
+            return 0.0f;
+        }
+        float GetPermanentActorValue(ActorRef a, ActorStat av) const override {
+            const auto& s = Get(a);
+            switch (av) {
+                case ActorStat::Health:
+                    return s.maxHealth;
+                case ActorStat::Stamina:
+                    return s.maxStamina;
+                case ActorStat::Magicka:
+                    return s.maxMagicka;
+                default:
+                    return GetActorValue(a, av);
+            }
+        }
+        void ModActorValue(ActorRef a, ActorStat av, float delta) override {
+            auto& s = Get(a);
+            ++avWrites;
+            switch (av) {
+                case ActorStat::SpeedMult:
+                    s.speedMult += delta;
+                    break;
+                case ActorStat::WeaponSpeedMult:
+                    s.weaponSpeedMult += delta;
+                    break;
+                case ActorStat::Health:
+                    s.health += delta;
+                    break;
+                case ActorStat::Stamina:
+                    s.stamina += delta;
+                    break;
+                case ActorStat::Magicka:
+                    s.magicka += delta;
+                    break;
+            }
+        }
+
+        bool ForceSpeedRefresh(ActorRef) override {
+            ++forceRefreshCalls;
+            return true;
+        }
+        void RequestRefresh(ActorRef) override { ++requestRefreshCalls; }
+        void PublishSweat(ActorRef, float) override { ++sweatCalls; }
+        void ClearSweat(ActorRef) override { ++sweatCalls; }
+
+        void Spawn(std::size_t n) {
+            std::uniform_real_distribution<float> pos(-4000.0f, 4000.0f);
+            std::uniform_real_distribution<float> ang(0.0f, 6.2831853f);
+            std::uniform_real_distribution<float> spd(80.0f, 320.0f);
+            std::uniform_real_distribution<float> scl(0.85f, 1.15f);
+            std::uniform_real_distribution<float> wgt(0.0f, 30.0f);
+
+            actors_.resize(n + 1);
+            for (std::size_t i = 0; i < actors_.size(); ++i) {
+                auto& s = actors_[i];
+                s.formID = (i == 0) ? ActorStateTable::kPlayerFormID : static_cast<std::uint32_t>(0xFF000000u + i);
+                s.pos = {pos(rng_), pos(rng_), 0.0f};
+                s.pos.z = Height(s.pos.x, s.pos.y);
+                s.heading = ang(rng_);
+                s.speed = spd(rng_);
+                s.scale = scl(rng_);
+                s.equippedWeight = wgt(rng_);
+                s.armor = {wgt(rng_) * 2.0f, wgt(rng_)};
+            }
+            // Keep everyone inside the NPC radius around the player
+            actors_[0].pos = {0.0f, 0.0f, Height(0.0f, 0.0f)};
+
+            refs_.clear();
+            for (std::size_t i = 1; i < actors_.size(); ++i) {
+                refs_.push_back(ActorRef{&actors_[i], actors_[i].formID});
+            }
+        }
+
+        ActorRef PlayerRef() { return ActorRef{&actors_[0], actors_[0].formID}; }
+        const std::vector<ActorRef>& NPCRefs() const { return refs_; }
+
+        // Scripted behaviour + integration of the resulting SpeedMult
+        void Step(std::uint64_t dtMs) {
+            nowMs_ += dtMs;
+            const float dt = dtMs / 1000.0f;
+            std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+            for (auto& s : actors_) {
+                if (frozen) {
+                    s.sprinting = s.sneaking = s.combat = s.drawn = false;
+                    s.moveX = s.moveY = 0.0f;
+                    continue;
+                }
+                if (nowMs_ >= s.nextFlipMs) {
+                    s.nextFlipMs = nowMs_ + 1500 + static_cast<std::uint64_t>(u(rng_) * 4000.0f);
+                    s.sprinting = u(rng_) < 0.25f;
+                    s.sneaking = !s.sprinting && u(rng_) < 0.15f;
+                    s.combat = u(rng_) < 0.10f;
+                    s.drawn = s.combat || u(rng_) < 0.20f;
+                    s.heading += (u(rng_) - 0.5f) * 2.0f;
+
+                    const int dir = static_cast<int>(u(rng_) * 8.0f);
+                    s.moveX = (dir == 1 || dir == 2 || dir == 3) ? 1.0f : (dir == 5 || dir == 6 || dir == 7) ? -1.0f : 0.0f;
+                    s.moveY = (dir == 0 || dir == 1 || dir == 7) ? 1.0f : (dir == 3 || dir == 4 || dir == 5) ? -1.0f : 0.0f;
+
+                    s.stamina = s.maxStamina * u(rng_);
+                    s.health = s.maxHealth * (0.3f + 0.7f * u(rng_));
+                }
+
+                const float v = s.speed * std::max(0.0f, s.speedMult) / 100.0f * (s.sprinting ? 1.6f : 1.0f);
+                s.pos.x += std::cos(s.heading) * v * dt;
+                s.pos.y += std::sin(s.heading) * v * dt;
+                s.pos.z = Height(s.pos.x, s.pos.y);
+            }
+        }
+
+        bool frozen = false;  // everyone stands still (AFK scenario)
+
+        std::uint64_t avWrites = 0;
+        std::uint64_t forceRefreshCalls = 0;    // ActorAccess::ForceSpeedRefresh, what reaches the engine
+        std::uint64_t requestRefreshCalls = 0;  // ActorAccess::RequestRefresh, deferred to the controller
+        std::uint64_t sweatCalls = 0;
+
+    private:
+        static SimActor& Get(ActorRef a) { return *static_cast<SimActor*>(a.handle); }
+
+        std::mt19937 rng_;
+        std::uint64_t nowMs_ = 1000;
+        std::vector<SimActor> actors_;
+        std::vector<ActorRef> refs_;
+    };
+
+    struct Options {
+        std::size_t actors = 2000;
+        std::size_t ticks = 600;
+        std::uint32_t seed = 1;
+        std::uint64_t dtMs = 33;
+        bool slope = true;
+        bool diag = true;
+        bool smoothing = true;
+        bool lod = true;
+        int budgetUs = 0;
+        std::size_t idleAfter = 0;  // 0 = never, else freeze all actors from this tick on
+    };
+
+    bool ParseArgs(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const char* k = argv[i];
+            const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (!v) {
+                std::fprintf(stderr, "missing value for %s\n", k);
+                return false;
+            }
+            if (!std::strcmp(k, "--actors"))
+                o.actors = std::strtoull(v, nullptr, 10);
+            else if (!std::strcmp(k, "--ticks"))
+                o.ticks = std::strtoull(v, nullptr, 10);
+            else if (!std::strcmp(k, "--seed"))
+                o.seed = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+            else if (!std::strcmp(k, "--dt-ms"))
+                o.dtMs = std::max<std::uint64_t>(1, std::strtoull(v, nullptr, 10));
+            else if (!std::strcmp(k, "--slope"))
+                o.slope = std::atoi(v) != 0;
+            else if (!std::strcmp(k, "--diag"))
+                o.diag = std::atoi(v) != 0;
+            else if (!std::strcmp(k, "--smoothing"))
+                o.smoothing = std::atoi(v) != 0;
+            else if (!std::strcmp(k, "--budget-us"))
+                o.budgetUs = std::atoi(v);
+            else if (!std::strcmp(k, "--lod"))
+                o.lod = std::atoi(v) != 0;
+            else if (!std::strcmp(k, "--idle-after"))
+                o.idleAfter = std::strtoull(v, nullptr, 10);
+            else {
+                std::fprintf(stderr, "unknown option %s\n", k);
+                return false;
+            }
+            ++i;
+        }
+        return true;
+    }
+
+    double Percentile(std::vector<double> v, double p) {
+        if (v.empty()) return 0.0;
+        std::sort(v.begin(), v.end());
+        const auto idx = static_cast<std::size_t>(std::clamp(p, 0.0, 1.0) * (v.size() - 1));
+        return v[idx];
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) return 2;
+
+    Settings::enableSpeedScalingForNPCs = true;
+    Settings::npcRadius = 0;
+    Settings::eventDebounceMs = 0;
+    Settings::slopeEnabled = opt.slope;
+    Settings::slopeAffectsNPCs = opt.slope;
+    Settings::enableDiagonalSpeedFix = opt.diag;
+    Settings::enableDiagonalSpeedFixForNPCs = opt.diag;
+    Settings::smoothingEnabled = opt.smoothing;
+    Settings::smoothingAffectsNPCs = opt.smoothing;
+    Settings::dwEnabled = false;
+    Settings::npcLodEnabled = opt.lod;
+    Settings::npcBudgetUs = opt.budgetUs;
+    Settings::Publish();  // the core only sees published settings
+
+    SimWorld world(opt.seed);
+    world.Spawn(opt.actors);
+
+    SpeedCore core(world);
+    core.SetPlayer(world.PlayerRef());
+
+    std::vector<double> tickUs;
+    tickUs.reserve(opt.ticks);
+    std::size_t quietTicks = 0;  // ticks the heartbeat scheduler would count towards idle
+
+    for (std::size_t t = 0; t < opt.ticks; ++t) {
+        if (opt.idleAfter && t == opt.idleAfter) world.frozen = true;
+        world.Step(opt.dtMs);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        core.SyncSettings();
+        core.Tick(world.NPCRefs());
+        core.FlushRefreshes(world.NPCRefs());
+        const auto t1 = std::chrono::steady_clock::now();
+
+        tickUs.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        if (!core.ConsumeActivity()) ++quietTicks;
+    }
+
+    double sum = 0.0;
+    for (double v : tickUs) sum += v;
+    const double mean = tickUs.empty() ? 0.0 : sum / tickUs.size();
+    const double maxv = tickUs.empty() ? 0.0 : *std::max_element(tickUs.begin(), tickUs.end());
+    const double perActorNs = (opt.actors + 1) ? mean * 1000.0 / (opt.actors + 1) : 0.0;
+
+    std::printf("actors=%zu ticks=%zu seed=%u dt_ms=%llu slope=%d diag=%d smoothing=%d lod=%d budget_us=%d\n",
+                opt.actors, opt.ticks, opt.seed, static_cast<unsigned long long>(opt.dtMs), opt.slope, opt.diag,
+                opt.smoothing, opt.lod, opt.budgetUs);
+    std::printf("tick_us mean=%.2f p50=%.2f p95=%.2f p99=%.2f max=%.2f per_actor_ns=%.1f\n", mean,
+                Percentile(tickUs, 0.50), Percentile(tickUs, 0.95), Percentile(tickUs, 0.99), maxv, perActorNs);
+    std::printf("av_writes=%llu force_refresh_calls=%llu request_refresh_calls=%llu sweat_calls=%llu tracked_npcs=%zu "
+                "quiet_ticks=%zu\n",
+                static_cast<unsigned long long>(world.avWrites),
+                static_cast<unsigned long long>(world.forceRefreshCalls),
+                static_cast<unsigned long long>(world.requestRefreshCalls),
+                static_cast<unsigned long long>(world.sweatCalls), core.Actors().TrackedNPCs(), quietTicks);
+    const auto& lod = core.LastTickLod();
+    std::printf("lod_last_tick near=%u mid=%u far=%u out=%u updated=%u\n", lod.tier[0], lod.tier[1], lod.tier[2],
+                lod.tier[3], lod.updated);
+    const auto& sl = core.Slicing();
+    std::printf("slice_last_tick processed=%u total=%u budget_stops=%llu round_trip_ms=%llu\n", sl.processed,
+                sl.total, static_cast<unsigned long long>(sl.budgetStops),
+                static_cast<unsigned long long>(sl.roundTripMs));
+    const auto& ws = core.Stats();
+    std::printf("speedmult_writes component=%llu engine=%llu cancelled=%llu\n",
+                static_cast<unsigned long long>(ws.componentWrites), static_cast<unsigned long long>(ws.engineWrites),
+                static_cast<unsigned long long>(ws.cancelledCommits));
+    const auto& cs = core.CaseStats();
+    std::printf("case_cache targets=%llu rebuilt state=%llu armor=%llu vitals=%llu scale=%llu armor_reads=%llu "
+                "location_lookups=%llu beast_checks=%llu\n",
+                static_cast<unsigned long long>(cs.targets), static_cast<unsigned long long>(cs.rebuilt[0]),
+                static_cast<unsigned long long>(cs.rebuilt[1]), static_cast<unsigned long long>(cs.rebuilt[2]),
+                static_cast<unsigned long long>(cs.rebuilt[3]), static_cast<unsigned long long>(cs.armorReads),
+                static_cast<unsigned long long>(cs.locationLookups), static_cast<unsigned long long>(cs.beastChecks));
+    const auto& rf = core.Refreshes();
+    // SpeedCore's refresh queue: QueueRefresh calls, folded into an already queued entry, held back by the minimum
+    // interval, and flushed to ForceSpeedRefresh (= force_refresh_calls above)
+    std::printf("refresh_queue queue_calls=%llu coalesced=%llu throttled=%llu flushed=%llu\n",
+                static_cast<unsigned long long>(rf.requested), static_cast<unsigned long long>(rf.coalesced),
+                static_cast<unsigned long long>(rf.throttled), static_cast<unsigned long long>(rf.executed));
+    return 0;
+}